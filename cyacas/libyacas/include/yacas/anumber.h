@@ -1,6 +1,7 @@
 #ifndef YACAS_ANUMBER_H
 #define YACAS_ANUMBER_H
 
+#include "arena.h"
 #include "lispstring.h"
 
 #include <cassert>
@@ -11,10 +12,35 @@
 // number module. The larger they are the better. PlatDoubleWord
 // should be at least twice as big as PlatWord, to prevent overflowing
 // during multiplication.
+//
+// The width of PlatWord is selected at compile time by defining
+// YACAS_PLATWORD_BITS to 16, 32 or 64. By default 64 bit words are used
+// on platforms where the compiler offers a 128 bit integer type for the
+// intermediate results, and 32 bit words elsewhere.
+
+#ifndef YACAS_PLATWORD_BITS
+#  if defined(__SIZEOF_INT128__) && (defined(__x86_64__) || defined(__aarch64__))
+#    define YACAS_PLATWORD_BITS 64
+#  else
+#    define YACAS_PLATWORD_BITS 32
+#  endif
+#endif
 
+#if YACAS_PLATWORD_BITS == 64
+typedef unsigned long long PlatWord;
+__extension__ typedef unsigned __int128 PlatDoubleWord;
+__extension__ typedef __int128 PlatSignedDoubleWord;
+#elif YACAS_PLATWORD_BITS == 32
+typedef unsigned int PlatWord;
+typedef unsigned long long PlatDoubleWord;
+typedef signed long long PlatSignedDoubleWord;
+#elif YACAS_PLATWORD_BITS == 16
 typedef unsigned short PlatWord;
 typedef unsigned long PlatDoubleWord;
 typedef signed long PlatSignedDoubleWord;
+#else
+#  error "YACAS_PLATWORD_BITS must be 16, 32 or 64"
+#endif
 
 /* Quantities derived from the platform-dependent types for doing
  * arithmetic.
@@ -26,9 +52,10 @@ typedef signed long PlatSignedDoubleWord;
 
 /* Class ANumber represents an arbitrary precision number. it is
  * basically an array of PlatWord objects, with the first element
- * being the least significant. iExp <= 0 for integers.
+ * being the least significant. iExp <= 0 for integers. The words are
+ * allocated from the arena of the environment.
  */
-class ANumber : public std::vector<PlatWord>
+class ANumber : public std::vector<PlatWord, ArenaAllocator<PlatWord>>
 {
 public:
     ANumber(const char* aString,int aPrecision,int aBase=10);
@@ -56,6 +83,9 @@ public:
 
     void Print(std::ostream&, const std::string& prefix) const;
 
+    static void* operator new(std::size_t size) { return Arena::Allocate(size); }
+    static void operator delete(void* object, std::size_t size) { Arena::Free(object, size); }
+
 public:
     int iExp;
     bool iNegative;
@@ -94,7 +124,20 @@ void BaseShiftLeft(ANumber& a, int aNrBits);
 void BaseGcd(ANumber& aResult, ANumber& a1, ANumber& a2);
 void Sqrt(ANumber& aResult, ANumber& N);
 
-void NormalizeFloat(ANumber& a2, int digitsNeeded);
+void NormalizeFloat(ANumber& a2, int aPrecision);
+
+// Operand sizes, in words, from which multiplication switches from the
+// schoolbook method to Karatsuba's method, from that to Toom-Cook 3-way
+// splitting, and finally to number theoretic transforms. The best values
+// depend on the machine.
+struct MultiplyThresholds {
+    int karatsuba;
+    int toom3;
+    int ntt;
+};
+
+MultiplyThresholds GetMultiplyThresholds();
+void SetMultiplyThresholds(const MultiplyThresholds& aThresholds);
 
 inline
 void ANumber::Negate()
@@ -348,8 +348,10 @@ inline void WordBaseDivide(T& aQuotient, T& aRemainder, T& a1, T& a2)
         PlatDoubleWord q = (a1[j+n]*WordBase+a1[j+n-1])/a2[n-1];
         PlatDoubleWord r = (a1[j+n]*WordBase+a1[j+n-1])%a2[n-1];
 
+        // The products below fit in a PlatDoubleWord only as long as
+        // q and r are less than WordBase, so test those first.
     REDO:
-        if (q == WordBase || q*a2[n-2] > WordBase*r+a1[j+n-2])
+        if (q >= WordBase || q*a2[n-2] > (r<<WordBits)+a1[j+n-2])
         {
             q = q - 1;
             r = r + a2[n-1];
@@ -0,0 +1,149 @@
+/** \file arena.h
+ *  Memory for the objects of a Yacas environment.
+ *
+ *  Lisp objects, big numbers and the words of their mantissas are
+ *  allocated from the arena that is current on the calling thread, which
+ *  an Arena::Scope selects, or from the shared arena outside any scope.
+ *  Each environment has its own arena, so several environments can be
+ *  used in parallel threads without contending for a lock, and all
+ *  memory of an environment is released at once when it is destroyed.
+ *
+ *  An arena, and the objects allocated from it, may be used by only one
+ *  thread at a time, and its blocks are freed where it is current or
+ *  once it is no longer in use. Objects must not outlive the arena they
+ *  were allocated from.
+ */
+
+#ifndef YACAS_ARENA_H
+#define YACAS_ARENA_H
+
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <mutex>
+
+class Arena: NonCopyable {
+public:
+    /// Construct an arena; an Arena::Scope makes it current
+    Arena();
+    /// Release all memory allocated from the arena
+    ~Arena();
+
+    /// Allocate from the current arena
+    static void* Allocate(std::size_t aSize);
+    /// Return a block to the arena it was allocated from. aSize must
+    /// be the size it was allocated with.
+    static void Free(void* aBlock, std::size_t aSize);
+
+    /// The current arena, or the shared one if there is none
+    static Arena& Current();
+
+    /// Makes an arena current on the calling thread for its lifetime. A
+    /// null arena selects the shared arena, which is never released and
+    /// is the one to use for objects which outlive all environments.
+    class Scope: NonCopyable {
+    public:
+        explicit Scope(Arena* aArena);
+        ~Scope();
+
+    private:
+        Arena* iPrevious;
+    };
+
+    struct Statistics {
+        std::size_t blocks;      ///< small blocks in use
+        std::size_t bytes;       ///< bytes in small blocks in use
+        std::size_t large;       ///< large blocks in use
+        std::size_t largeBytes;  ///< bytes in large blocks in use
+        std::size_t chunks;      ///< chunks carved into small blocks
+        std::size_t reserved;    ///< bytes reserved for chunks
+        std::size_t allocations; ///< allocations since construction
+    };
+
+    Statistics GetStatistics();
+
+private:
+    struct Chunk;
+    struct Large;
+    struct Region;
+
+    // Blocks up to MaxSmall bytes are rounded up to a multiple of
+    // Granularity, and carved out of chunks holding blocks of one size
+    // each. Chunks are aligned to their size, so the chunk of a block is
+    // found from its address. Larger blocks are allocated separately.
+    static const std::size_t Granularity = 16;
+    static const std::size_t MaxSmall = 512;
+    static const std::size_t NrClasses = MaxSmall / Granularity;
+    static const std::size_t ChunkSize = 64 * 1024;
+    static const std::size_t ChunksPerRegion = 16;
+
+    explicit Arena(bool aShared);
+
+    void* AllocateSmall(std::size_t aClass);
+    void FreeSmall(void* aBlock, std::size_t aClass);
+    void* AllocateLarge(std::size_t aSize);
+    void FreeLarge(Large* aLarge);
+    Chunk* NewChunk();
+
+    static Arena& Shared();
+    static thread_local Arena* current;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Class {
+        FreeBlock* free;
+        char* next;
+        char* end;
+        std::size_t blocks;
+    };
+
+    Class iClasses[NrClasses];
+    Region* iRegions;
+    std::size_t iFreeChunks;
+    Large* iLarge;
+    std::size_t iNrLarge;
+    std::size_t iLargeBytes;
+    std::size_t iNrChunks;
+    std::size_t iAllocations;
+
+    // only the shared arena, which is used by any thread, is locked
+    bool iShared;
+    std::mutex iMutex;
+};
+
+/// Allocates from the current arena, for containers whose storage
+/// belongs to an environment.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator() = default;
+    template <typename U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(Arena::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        Arena::Free(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+inline bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return true;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return false;
+}
+
+#endif
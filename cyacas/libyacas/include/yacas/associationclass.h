@@ -29,16 +29,24 @@
 #include "genericobject.h"
 #include "standard.h"
 
+#include <list>
 #include <map>
+#include <unordered_map>
 
 class AssociationClass final: public GenericClass
 {
 public:
-    AssociationClass(const LispEnvironment& env);
+    /// How the entries are kept: sorted by InternalStrictTotalOrder()
+    /// of their keys, or by the hash of their keys, in the order in
+    /// which they were added
+    enum Backend { Sorted, Hashed };
+
+    AssociationClass(const LispEnvironment& env, Backend backend = Sorted);
     const char* TypeName() const override;
 
+    Backend GetBackend() const;
     std::size_t Size() const;
-    bool Contains(LispObject* k) const;
+    bool Contains(LispObject* k);
     LispObject* GetElement(LispObject* k);
     void SetElement(LispObject* k,LispObject* v);
     bool DropElement(LispObject* k);
@@ -47,13 +55,18 @@ public:
     LispPtr Head() const;
     
 private:
+    // The hash of a key is computed up front. This caches the hashes of
+    // the lists in it, so that InternalEquals() tells most unequal lists
+    // nested in keys apart without walking them.
     class Key {
     public:
         Key(const LispEnvironment& env, LispObject* p):
-            value(p), _env(env) {}
+            value(p), hash(InternalHash(env, value)), _env(env) {}
         
         bool operator == (const Key& rhs) const
         {
+            if (InternalHashIsExact(hash) && InternalHashIsExact(rhs.hash) && hash != rhs.hash)
+                return false;
             return InternalEquals(_env, value, rhs.value);
         }
         
@@ -63,18 +76,37 @@ private:
         }
 
         LispPtr value;
+        std::size_t hash;
 
     private:
         const LispEnvironment& _env;
     };
 
+    typedef std::list<std::pair<Key, LispPtr>> Entries;
+
+    /// The entry of a hashed association with key k, or end()
+    Entries::iterator Find(const Key& k);
+
+    /// Call f with the key and value of every entry, in order
+    template <typename F>
+    void ForEach(F f) const;
+
     const LispEnvironment& _env;
+    const Backend _backend;
+
     std::map<Key, LispPtr> _map;
+
+    Entries _entries;
+    // Entries by the hash of their key. Keys with an inexact hash may
+    // equal keys with any hash, and are all kept under 0, which is not
+    // an exact hash.
+    std::unordered_multimap<std::size_t, Entries::iterator> _index;
 };
 
 inline
-AssociationClass::AssociationClass(const LispEnvironment& env):
-    _env(env)
+AssociationClass::AssociationClass(const LispEnvironment& env, Backend backend):
+    _env(env),
+    _backend(backend)
 {
 }
 
@@ -85,36 +117,21 @@ const char* AssociationClass::TypeName() const
 }
 
 inline
-std::size_t AssociationClass::Size() const
-{
-    return _map.size();
-}
-
-inline
-bool AssociationClass::Contains(LispObject* k) const
-{
-    return _map.find(Key(_env, k)) != _map.end();
-}
-
-inline
-LispObject* AssociationClass::GetElement(LispObject* k)
+AssociationClass::Backend AssociationClass::GetBackend() const
 {
-    auto p = _map.find(Key(_env, k));
-    if (p != _map.end())
-        return p->second;
-    return nullptr;
+    return _backend;
 }
 
 inline
-void AssociationClass::SetElement(LispObject* k, LispObject* v)
+std::size_t AssociationClass::Size() const
 {
-    _map[Key(_env, LispPtr(k))] = v;
+    return _backend == Hashed ? _entries.size() : _map.size();
 }
 
 inline
-bool AssociationClass::DropElement(LispObject* k)
+bool AssociationClass::Contains(LispObject* k)
 {
-    return _map.erase(Key(_env, LispPtr(k)));
+    return GetElement(k) != nullptr;
 }
 
 #endif /* ASSOCIATIONCLASS_H */
@@ -40,8 +40,13 @@ public:
 class LispDefFiles
 {
 public:
+    typedef std::unordered_map<std::string, LispDefFile>::const_iterator const_iterator;
+
     LispDefFile* File(const std::string& aFileName);
 
+    const_iterator begin() const { return _map.begin(); }
+    const_iterator end() const { return _map.end(); }
+
 private:
     std::unordered_map<std::string, LispDefFile> _map;
 };
@@ -0,0 +1,119 @@
+/** \file densematrix.h
+ *  Dense matrices of numbers, for the kernels behind linalg.rep.
+ *
+ *  The entries are held row by row in one vector. The kernels do the
+ *  arithmetic the scripts would do, with the same number functions, but
+ *  without indexing lists and matching rules for every entry.
+ */
+
+#ifndef YACAS_DENSEMATRIX_H
+#define YACAS_DENSEMATRIX_H
+
+#include "lispobject.h"
+
+#include <vector>
+
+class LispEnvironment;
+
+class DenseMatrix
+{
+public:
+    enum Kind { Integer, Float, Mixed };
+
+    DenseMatrix();
+    DenseMatrix(std::size_t aRows, std::size_t aColumns);
+
+    /// Read a list of rows of numbers, all of the same length. Returns
+    /// false if aList is not such a list.
+    bool Read(LispEnvironment& aEnvironment, LispObject* aList);
+
+    /// The list of rows
+    LispPtr ToList(LispEnvironment& aEnvironment) const;
+
+    std::size_t Rows() const;
+    std::size_t Columns() const;
+
+    /// Whether all the entries are integers, none are, or some are
+    Kind GetKind() const;
+
+    /// The entry in row aRow and column aColumn, counting from 0
+    LispPtr& operator()(std::size_t aRow, std::size_t aColumn);
+    const LispPtr& operator()(std::size_t aRow, std::size_t aColumn) const;
+
+    /// The product of aX and aY, where aX has as many columns as aY
+    /// has rows. Integer products which fit in machine words are
+    /// computed in blocks of machine words.
+    static DenseMatrix Multiply(LispEnvironment& aEnvironment, const DenseMatrix& aX, const DenseMatrix& aY);
+
+    /// The determinant of a square integer matrix, by fraction-free
+    /// Gaussian elimination (Bareiss)
+    static LispPtr Determinant(LispEnvironment& aEnvironment, DenseMatrix aMatrix);
+
+    /// Solve aMatrix X = aRight, for a square integer matrix and integer
+    /// right hand sides, without fractions. On success X is aNumerators
+    /// divided by aDenominator, both integer. Returns false if aMatrix
+    /// is singular.
+    static bool Solve(LispEnvironment& aEnvironment, const DenseMatrix& aMatrix, const DenseMatrix& aRight,
+                      LispPtr& aDenominator, DenseMatrix& aNumerators);
+
+    /// The decomposition of a square matrix into aL and aU without
+    /// pivoting, as LU in linalg.rep computes it in numeric mode.
+    /// Returns false if a pivot vanishes.
+    static bool LU(LispEnvironment& aEnvironment, const DenseMatrix& aMatrix, DenseMatrix& aL, DenseMatrix& aU);
+
+private:
+    std::size_t iRows;
+    std::size_t iColumns;
+    Kind iKind;
+    std::vector<LispPtr> iEntries;
+};
+
+inline
+DenseMatrix::DenseMatrix():
+    iRows(0),
+    iColumns(0),
+    iKind(Integer),
+    iEntries()
+{
+}
+
+inline
+DenseMatrix::DenseMatrix(std::size_t aRows, std::size_t aColumns):
+    iRows(aRows),
+    iColumns(aColumns),
+    iKind(Integer),
+    iEntries(aRows * aColumns)
+{
+}
+
+inline
+std::size_t DenseMatrix::Rows() const
+{
+    return iRows;
+}
+
+inline
+std::size_t DenseMatrix::Columns() const
+{
+    return iColumns;
+}
+
+inline
+DenseMatrix::Kind DenseMatrix::GetKind() const
+{
+    return iKind;
+}
+
+inline
+LispPtr& DenseMatrix::operator()(std::size_t aRow, std::size_t aColumn)
+{
+    return iEntries[aRow * iColumns + aColumn];
+}
+
+inline
+const LispPtr& DenseMatrix::operator()(std::size_t aRow, std::size_t aColumn) const
+{
+    return iEntries[aRow * iColumns + aColumn];
+}
+
+#endif
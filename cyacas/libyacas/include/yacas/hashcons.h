@@ -0,0 +1,48 @@
+/** \file hashcons.h
+ *  Sharing of equal subexpressions.
+ *
+ *  A hash-consing table makes equal lists share their elements, so that
+ *  an expression built from many equal parts takes the memory of one,
+ *  and InternalEquals() finds the shared parts equal without walking
+ *  them. Lists are shared only if InternalHash() finds them exact, that
+ *  is when they hold no floating point numbers, which compare equal
+ *  only to within the precision. Shared lists must not be changed in
+ *  place, since that changes every expression sharing them.
+ */
+
+#ifndef YACAS_HASHCONS_H
+#define YACAS_HASHCONS_H
+
+#include "lispobject.h"
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <unordered_map>
+
+class LispEnvironment;
+
+class HashConsTable: NonCopyable {
+public:
+    HashConsTable();
+
+    /// Return an expression equal to \a aExpression, which shares its
+    /// lists with equal lists returned before.
+    LispPtr Intern(LispEnvironment& aEnvironment, const LispPtr& aExpression);
+
+    /// The number of shared lists
+    std::size_t Size() const { return iLists.size(); }
+
+    /// Stop sharing all lists
+    void Clear();
+
+private:
+    /// Forget lists that nothing else uses
+    void Sweep();
+
+    /// the shared lists, by hash
+    std::unordered_multimap<std::size_t, LispPtr> iLists;
+    /// the size at which to sweep next
+    std::size_t iSweepSize;
+};
+
+#endif
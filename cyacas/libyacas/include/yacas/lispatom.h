@@ -16,6 +16,9 @@
  * The string is held in the number (to avoid repeated conversions) and also cached in the string cache (this caching will eventually be abandoned).
  * When LispNumber is constructed from BigNumber, no string representation is available.
  * Conversion from string to BigNumber is done only if no BigNumber object is present.
+ * Integers that fit in a machine word are held inline instead, and get a BigNumber
+ * only when one is asked for; the arithmetic and comparison commands work on them
+ * directly, so that loop counters and indices do not allocate numbers.
  */
 
 #ifndef YACAS_LISPATOM_H
@@ -69,13 +72,28 @@ public:
   ~LispSubList() override;
   LispPtr* SubList() override { return &iSubList; }
   LispObject* Copy() const override { return new LispSubList(*this); }
+
+  /// Get the structural hash of the list, see InternalHash(), if it was
+  /// cached in hash generation aGeneration.
+  bool CachedHash(std::uint64_t aGeneration, std::size_t& aHash) const
+  {
+    aHash = iHash;
+    return iHashGeneration == aGeneration;
+  }
+  void CacheHash(std::uint64_t aGeneration, std::size_t aHash)
+  {
+    iHashGeneration = aGeneration;
+    iHash = aHash;
+  }
 private:
   // Constructor is private -- use New() instead
-  LispSubList(LispObject* aSubList) : iSubList(aSubList) {}  // iSubList's constructor is messed up (it's a LispPtr, duh)
+  LispSubList(LispObject* aSubList) : iHashGeneration(0), iSubList(aSubList), iHash(0) {}  // iSubList's constructor is messed up (it's a LispPtr, duh)
 public:
-  LispSubList(const LispSubList& other): LispObject(other), iSubList(other.iSubList) {}
+  LispSubList(const LispSubList& other): LispObject(other), iHashGeneration(other.iHashGeneration), iSubList(other.iSubList), iHash(other.iHash) {}
 private:
+  std::uint64_t iHashGeneration;
   LispPtr iSubList;
+  std::size_t iHash;
 };
 
 
@@ -110,21 +128,35 @@ class LispNumber: public LispObject
 public:
     /// constructors:
     /// construct from another LispNumber
-  LispNumber(BigNumber* aNumber) : iNumber(aNumber), iString(nullptr) {}
-  LispNumber(const LispNumber& other) : LispObject(other), iNumber(other.iNumber), iString(other.iString) {}
+  LispNumber(BigNumber* aNumber) : iNumber(aNumber), iString(nullptr), iIsSmall(false), iSmall(0), iPrecision(0), iMantissaPrecision(0) {}
+  LispNumber(const LispNumber& other) : LispObject(other), iNumber(other.iNumber), iString(other.iString),
+    iIsSmall(other.iIsSmall), iSmall(other.iSmall), iPrecision(other.iPrecision), iMantissaPrecision(other.iMantissaPrecision) {}
   /// construct from a decimal string representation (also create a number object) and use aBasePrecision decimal digits
-  LispNumber(LispString * aString, int aBasePrecision) : iNumber(nullptr), iString(aString) { Number(aBasePrecision); }
+  LispNumber(LispString * aString, int aBasePrecision);
+  /// construct a small integer; aPrecision (in bits) and aMantissaPrecision (in decimal digits) are given to the BigNumber if one is created
+  LispNumber(std::int64_t aValue, int aPrecision, int aMantissaPrecision) : iNumber(nullptr), iString(nullptr),
+    iIsSmall(true), iSmall(aValue), iPrecision(aPrecision), iMantissaPrecision(aMantissaPrecision) {}
 
   LispObject* Copy() const override { return new LispNumber(*this); }
   /// return a string representation in decimal with maximum decimal precision allowed by the inherent accuracy of the number
   LispString * String() override;
   /// give access to the BigNumber object; if necessary, will create a BigNumber object out of the stored string, at given precision (in decimal?)
   BigNumber* Number(int aPrecision) override;
+  bool SmallInteger(std::int64_t& aValue) override;
+
+  /// precisions of a small integer, as they would be set in its BigNumber
+  int SmallPrecision() const { return iPrecision; }
+  int SmallMantissaPrecision() const { return iMantissaPrecision; }
 private:
   /// number object; nullptr if not yet converted from string
   RefPtr<BigNumber> iNumber;
   /// string representation in decimal; nullptr if not yet converted from BigNumber
   RefPtr<LispString> iString;
+  /// whether the value is held in iSmall
+  bool iIsSmall;
+  std::int64_t iSmall;
+  int iPrecision;
+  int iMantissaPrecision;
 };
 
 
@@ -8,6 +8,7 @@
 
 #include "lispobject.h"
 #include "lisphash.h"
+#include "hashcons.h"
 #include "lispevalhash.h"
 #include "lispuserfunc.h"
 #include "deffile.h"
@@ -21,6 +22,9 @@
 #include "noncopyable.h"
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -42,6 +46,20 @@ class LispEvaluatorBase;
 class BasicEvaluator;
 class DefaultDebugger;
 class LispEnvironment;
+class ParallelClones;
+
+/// Limits on a single evaluation, each of which is not imposed if it
+/// is zero. Going over one of them aborts the evaluation with
+/// LispErrBudgetExceeded.
+struct EvaluationBudget {
+  /// calls to LispEvaluatorBase::Eval
+  unsigned long long steps = 0;
+  /// wall-clock time, in seconds
+  double seconds = 0;
+  /// bytes of objects allocated from the arena, beyond those in use
+  /// when the evaluation starts
+  std::size_t bytes = 0;
+};
 
 
 /// The Lisp environment.
@@ -101,8 +119,12 @@ public:
   void GetVariable(const LispString* aVariable, LispPtr& aResult);
 
   void UnsetVariable(const LispString * aString);
+  const LispGlobal& Globals() const { return iGlobals; }
   void PushLocalFrame(bool aFenced);
   void PopLocalFrame();
+  /// Pop the innermost frame, but keep its first \a aCount variables,
+  /// which become variables of the enclosing frame.
+  void MergeLocalFrame(std::size_t aCount);
   void NewLocal(const LispString* aVariable, LispObject* aValue);
   void CurrentLocals(LispPtr& aResult);
   //@}
@@ -157,6 +179,69 @@ public:
   void Protect(const LispString*);
   void UnProtect(const LispString*);
   bool Protected(const LispString*) const;
+  const LispIdentifiers& ProtectedSymbols() const { return protected_symbols; }
+  //@}
+
+public:
+  /// \name Dispatch cache
+  //@{
+
+  /// The core command or user function found for calls of iName with
+  /// iArity arguments, or neither if there is none. The entry is valid
+  /// while iGeneration equals DispatchGeneration().
+  struct Dispatch {
+    LispStringSmartPtr iName;
+    int iArity;
+    unsigned long iGeneration;
+    const YacasEvaluator* iCoreCommand;
+    LispUserFunction* iUserFunction;
+  };
+
+  /// Return the cache entry for calls of aName with aArity arguments.
+  /// The entry may belong to another function, or be out of date.
+  inline Dispatch& DispatchEntry(const LispString* aName, int aArity);
+  unsigned long DispatchGeneration() const { return iDispatchGeneration; }
+
+  /// Invalidate all cached dispatch entries. This is needed whenever a
+  /// core command, rule base or definition file is added or removed.
+  void InvalidateDispatchCache() { iDispatchGeneration++; DefinitionsChanged(); }
+  //@}
+
+public:
+  /// \name Structural hashes
+  //@{
+
+  /// Hashes cached in lists, see InternalHash(), are valid if they were
+  /// computed in this generation. Generations are 64 bits wide, so that
+  /// they never wrap around to one in which hashes were cached before.
+  std::uint64_t HashGeneration() const { return iHashGeneration; }
+
+  /// Invalidate all cached hashes. This is needed whenever a list is
+  /// changed in place, as it may be an element of any other list.
+  void InvalidateHashes() { ++iHashGeneration; GlobalsChanged(); }
+
+  /// The expressions shared by HashCons
+  HashConsTable& HashConsed() { return iHashConsed; }
+  //@}
+
+public:
+  /// \name Definitions
+  //@{
+
+  /// Changes whenever something that a snapshot holds, besides the
+  /// precision and the global variables, may have changed: a rule base,
+  /// rule, operator, definition file or protected symbol.
+  std::uint64_t DefinitionsGeneration() const { return iDefinitionsGeneration; }
+  void DefinitionsChanged() { ++iDefinitionsGeneration; }
+
+  /// Changes whenever a global variable may have changed: it was set or
+  /// unset, or a list or generic object, which may be its value, was
+  /// changed in place.
+  std::uint64_t GlobalsGeneration() const { return iGlobalsGeneration; }
+  void GlobalsChanged() { ++iGlobalsGeneration; }
+
+  /// The clones of this environment kept by ParallelMap, see parallel.h
+  std::shared_ptr<ParallelClones> iParallelClones;
   //@}
 
 public:
@@ -206,9 +291,34 @@ protected:
   int iBinaryPrecision;
 public:
   std::vector<std::string> iInputDirectories;
+  /// names of the script and def files read so far, in the order in
+  /// which they were first read
+  std::vector<std::string> iLoadedFiles;
+  /// whether scripts are read from source and saved in compiled form
+  /// next to it, rather than read in compiled form when there is one
+  bool iCompileScripts;
+  /// values of pattern variables for the matches in progress, innermost
+  /// last, so that matching does not allocate
+  std::vector<LispPtr> iPatternBindings;
   //DeletingLispCleanup iCleanup;
   int iEvalDepth;
   int iMaxEvalDepth;
+
+  /// \name Evaluation budget
+  //@{
+  /// Start counting an evaluation against #iBudget.
+  void StartBudget();
+  /// Called by the evaluator when #iEvalSteps reaches
+  /// #iNextBudgetCheck. Throws LispErrBudgetExceeded if the
+  /// evaluation has gone over #iBudget, and keeps throwing it on every
+  /// step until the budget is started again, so that the evaluation
+  /// can not trap it and carry on.
+  void CheckBudget();
+
+  EvaluationBudget iBudget;
+  unsigned long long iEvalSteps;
+  unsigned long long iNextBudgetCheck;
+  //@}
 #ifdef YACAS_NO_ATOMIC_TYPES
   volatile bool
 #else
@@ -246,15 +356,18 @@ public: // Error reporting
 private:
     LispPtr *FindLocal(const LispString * aVariable);
 
+    // Local variables are bound shallowly: the name of a variable holds
+    // the index of its innermost binding, and each binding the index of
+    // the binding it hides, which is restored when its frame is popped.
     struct LispLocalVariable {
-        LispLocalVariable(const LispString* var, LispObject* val):
-        var(var), val(val)
+        LispLocalVariable(const LispString* var, LispObject* val, std::size_t hidden):
+        var(var), val(val), hidden(hidden)
         {
             ++var->iReferenceCount;
         }
 
         LispLocalVariable(const LispLocalVariable& v):
-        var(v.var), val(v.val)
+        var(v.var), val(v.val), hidden(v.hidden)
         {
             ++var->iReferenceCount;
         }
@@ -266,21 +379,41 @@ private:
 
         const LispString* var;
         LispPtr val;
+        std::size_t hidden;
     };
 
     struct LocalVariableFrame {
-        LocalVariableFrame(std::size_t first, bool fenced):
-        first(first), fenced(fenced)
+        LocalVariableFrame(std::size_t first, bool fenced, std::size_t fence):
+        first(first), fenced(fenced), fence(fence)
         {
         }
 
         std::size_t first;
         bool fenced;
+        // index of the first variable visible in this frame
+        std::size_t fence;
     };
 
     std::vector<LispLocalVariable> _local_vars;
     std::vector<LocalVariableFrame> _local_frames;
 
+    static const std::size_t DispatchCacheSize = 1024;
+    std::vector<Dispatch> iDispatchCache;
+    unsigned long iDispatchGeneration;
+
+    std::uint64_t iHashGeneration;
+    HashConsTable iHashConsed;
+
+    std::uint64_t iDefinitionsGeneration;
+    std::uint64_t iGlobalsGeneration;
+
+    // the budget is checked at least this often if it limits the time
+    // or the memory, which are more expensive to look at than the steps
+    static const unsigned long long BudgetCheckInterval = 1024;
+    std::chrono::steady_clock::time_point iBudgetDeadline;
+    std::size_t iBudgetBytes;
+    const char* iBudgetExceeded;
+
 public:
   std::ostream* iInitialOutput;
 
@@ -316,6 +449,12 @@ public:
   std::deque<LispPtr> iStack;
 };
 
+inline LispEnvironment::Dispatch& LispEnvironment::DispatchEntry(const LispString* aName, int aArity)
+{
+    const std::size_t h = (reinterpret_cast<std::size_t>(aName) >> 4) + 31 * static_cast<std::size_t>(aArity);
+    return iDispatchCache[h & (DispatchCacheSize - 1)];
+}
+
 inline int LispEnvironment::Precision(void) const
 {
     return iPrecision;
@@ -350,18 +489,27 @@ class LispLocalFrame
 {
 public:
     LispLocalFrame(LispEnvironment& aEnvironment, bool aFenced)
-        : iEnvironment(aEnvironment)
+        : iEnvironment(aEnvironment), iPopped(false)
     {
         iEnvironment.PushLocalFrame(aFenced);
     };
 
     virtual ~LispLocalFrame()
     {
-        iEnvironment.PopLocalFrame();
+        if (!iPopped)
+            iEnvironment.PopLocalFrame();
     };
 
+    /// Pop the frame now, keeping its first \a aCount variables
+    void Merge(std::size_t aCount)
+    {
+        iEnvironment.MergeLocalFrame(aCount);
+        iPopped = true;
+    }
+
 private:
     LispEnvironment& iEnvironment;
+    bool iPopped;
 };
 
 
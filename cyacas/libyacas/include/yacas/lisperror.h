@@ -196,6 +196,12 @@ public:
         LispError("User interrupted calculation") {}
 };
 
+class LispErrBudgetExceeded: public LispError {
+public:
+    explicit LispErrBudgetExceeded(const std::string& limit):
+        LispError(std::string("Evaluation budget exceeded: ") + limit) {}
+};
+
 class LispErrNonBooleanPredicateInPattern: public LispError {
 public:
     LispErrNonBooleanPredicateInPattern():
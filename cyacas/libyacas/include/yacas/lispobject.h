@@ -13,12 +13,15 @@
 #ifndef YACAS_LISPOBJECT_H
 #define YACAS_LISPOBJECT_H
 
+#include "arena.h"
 #include "refcount.h"
 #include "lispstring.h"
 #include "genericobject.h"
 #include "noncopyable.h"
 #include "stubs.h"
 
+#include <cstdint>
+
 class LispObject;
 class BigNumber;
 
@@ -61,6 +64,11 @@ public: //Derivables
    */
   virtual BigNumber* Number(int aPrecision) { return nullptr; }
 
+  /** If this is an integer held in a machine word, store it in aValue
+   *  and return true. Default behaviour is to return false.
+   */
+  virtual bool SmallInteger(std::int64_t& aValue) { return false; }
+
   virtual LispObject* Copy() const = 0;
 
 public:
@@ -88,9 +96,9 @@ private:
 public:
   unsigned iReferenceCount;
   
-  static inline void* operator new(size_t size) { return PlatAlloc(size); }
+  static inline void* operator new(size_t size) { return Arena::Allocate(size); }
   static inline void* operator new[](size_t size) { return PlatAlloc(size); }
-  static inline void operator delete(void* object) { PlatFree(object); }
+  static inline void operator delete(void* object, size_t size) { Arena::Free(object, size); }
   static inline void operator delete[](void* object) { PlatFree(object); }
   // Placement form of new and delete.
   static inline void* operator new(size_t, void* where) { return where; }
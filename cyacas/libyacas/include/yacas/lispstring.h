@@ -8,6 +8,7 @@
 
 #include "refcount.h"
 
+#include <cstddef>
 #include <string>
 
 class LispStringSmartPtr;
@@ -23,12 +24,20 @@ public:
 
 public:
     mutable unsigned iReferenceCount;
+
+    /// Index of the innermost local variable named by this string, or
+    /// NoBinding. Maintained by LispEnvironment::NewLocal and
+    /// LispEnvironment::PopLocalFrame.
+    mutable std::size_t iBinding;
+
+    static const std::size_t NoBinding = static_cast<std::size_t>(-1);
 };
 
 
 inline LispString::LispString(const std::string& s):
     std::string(s),
-    iReferenceCount(0)
+    iReferenceCount(0),
+    iBinding(NoBinding)
 {
 }
 
@@ -101,6 +101,9 @@ public:
   /// Delete tuser function with given arity.
   virtual void DeleteBase(int aArity);
 
+  /// Access #iFunctions.
+  const std::vector<LispArityUserFunction*>& Functions() const { return iFunctions; }
+
 private:
   /// Set of LispArityUserFunction's provided by this LispMultiUserFunction.
   std::vector<LispArityUserFunction*> iFunctions;
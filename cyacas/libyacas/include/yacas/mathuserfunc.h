@@ -2,9 +2,11 @@
 #define YACAS_MATHUSERFUNC_H
 
 #include "lispuserfunc.h"
+#include "memotable.h"
 #include "patternclass.h"
 #include "noncopyable.h"
 
+#include <memory>
 #include <vector>
 
 /// A mathematical function defined by several rules.
@@ -53,6 +55,9 @@ public:
 
     /// Access #iBody.
     LispPtr& Body();
+
+    /// Access #iPredicate.
+    LispPtr& Predicate() { return iPredicate; }
   protected:
     BranchRule() : iPrecedence(0),iBody(),iPredicate() {};
   protected:
@@ -100,6 +105,12 @@ public:
     /// Access #iBody
     LispPtr& Body();
 
+    /// Access #iPredicate
+    LispPtr& Predicate() { return iPredicate; }
+
+    /// Access #iPatternClass
+    const PatternClass& Pattern() const { return *iPatternClass; }
+
   protected:
     /// The precedence of this rule.
     int iPrecedence;
@@ -171,10 +182,39 @@ public:
   /// \f$n\f$ denotes the number of rules.
   void InsertRule(int aPrecedence,BranchRuleBase* newRule);
 
+  /// Add a rule after all rules in #iRules, whose precedence must not
+  /// be higher than that of the new rule. Unlike InsertRule(), this
+  /// keeps the order of rules with equal precedence.
+  void AppendRule(BranchRuleBase* newRule);
+
   /// Return the argument list, stored in #iParamList
   const LispPtr& ArgList() const override;
 
+  /// Access #iParameters
+  const std::vector<BranchParameter>& Parameters() const { return iParameters; }
+
+  /// Access #iRules
+  const std::vector<BranchRuleBase*>& Rules() const { return iRules; }
+
+  /// Remember the results of up to \a aCapacity calls, by their
+  /// arguments, so that calls with the same arguments return them
+  /// without evaluating a rule. A capacity of 0 stops remembering. The
+  /// results are forgotten when a rule is added.
+  void Memoize(std::size_t aCapacity);
+
+  /// The results remembered, nullptr if none are
+  const MemoTable* Memo() const { return iMemo.get(); }
+
 protected:
+  /// Find the first rule that matches, trying the rules in order.
+  /// \param aEnvironment the underlying Lisp environment
+  /// \param aArguments the values of the arguments, which have been
+  /// assigned to the parameters already
+  ///
+  /// Only the rules which #iIndex finds for the arguments are tried.
+  /// Returns nullptr if none matches.
+  BranchRuleBase* FirstMatch(LispEnvironment& aEnvironment, LispPtr* aArguments) const;
+
   /// List of arguments, with corresponding \c iHold property.
   std::vector<BranchParameter> iParameters;
 
@@ -183,6 +223,29 @@ protected:
 
   /// List of arguments
   LispPtr iParamList;
+
+private:
+  /// The patterns of the rules, to try only those which can match
+  struct RuleIndex {
+    /// the patterns, by position in #iRules
+    DiscriminationTree iTree;
+    /// the positions of rules which have no pattern
+    std::vector<std::size_t> iAlways;
+  };
+
+  void BuildIndex() const;
+
+  /// Changed whenever a rule is added, to find out whether #iIndex is
+  /// up to date, or whether rules were added while trying them.
+  std::size_t iVersion;
+
+  /// Built when needed, nullptr if no rule has a pattern
+  mutable std::unique_ptr<RuleIndex> iIndex;
+  mutable std::size_t iIndexVersion;
+
+  /// #iVersion when #iMemo was last cleared
+  mutable std::unique_ptr<MemoTable> iMemo;
+  mutable std::size_t iMemoVersion;
 };
 
 class ListedBranchingUserFunction final: public BranchingUserFunction
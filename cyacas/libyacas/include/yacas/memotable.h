@@ -0,0 +1,68 @@
+/** \file memotable.h
+ *  Results of a function, by its arguments.
+ *
+ *  A memo table remembers the results a function returned for the
+ *  arguments it was called with, so that calling it with the same
+ *  arguments again returns the result without evaluating anything.
+ *  Arguments are the same if InternalEquals() says so at the precision
+ *  they were used at. The table holds a bounded number of results, and
+ *  forgets the least recently used ones first. It keeps copies of the
+ *  arguments and results and hands out copies of the results, so that
+ *  changing either destructively doesn't change what it remembers.
+ */
+
+#ifndef YACAS_MEMOTABLE_H
+#define YACAS_MEMOTABLE_H
+
+#include "lispobject.h"
+#include "noncopyable.h"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+class LispEnvironment;
+
+class MemoTable: NonCopyable {
+public:
+    explicit MemoTable(std::size_t aCapacity);
+
+    /// The hash of \a aCount arguments, at the current precision
+    static std::size_t Hash(LispEnvironment& aEnvironment, LispPtr* aArguments, std::size_t aCount);
+
+    /// Set \a aResult to the result for the arguments with hash
+    /// \a aHash, if there is one.
+    bool Find(LispEnvironment& aEnvironment, std::size_t aHash, LispPtr* aArguments, std::size_t aCount, LispPtr& aResult);
+
+    /// Remember \a aResult for the arguments with hash \a aHash, which
+    /// must not be in the table.
+    void Insert(LispEnvironment& aEnvironment, std::size_t aHash, LispPtr* aArguments, std::size_t aCount, LispPtr& aResult);
+
+    /// Forget all results
+    void Clear();
+
+    std::size_t Capacity() const { return iCapacity; }
+    std::size_t Size() const { return iEntries.size(); }
+    std::size_t Hits() const { return iHits; }
+    std::size_t Misses() const { return iMisses; }
+
+private:
+    struct Entry {
+        std::size_t hash;
+        int precision;
+        std::vector<LispPtr> arguments;
+        LispPtr result;
+    };
+
+    typedef std::list<Entry> Entries;
+
+    std::size_t iCapacity;
+    /// most recently used first
+    Entries iEntries;
+    std::unordered_multimap<std::size_t, Entries::iterator> iIndex;
+    std::size_t iHits;
+    std::size_t iMisses;
+};
+
+#endif
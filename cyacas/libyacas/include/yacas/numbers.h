@@ -1,13 +1,24 @@
 #ifndef YACAS_NUMBERS_H
 #define YACAS_NUMBERS_H
 
+#include "arena.h"
 #include "lispenvironment.h"
 
+#include <cstdint>
+
 /// Whether the numeric library supports 1.0E-10 and such.
 int NumericSupportForMantissa();
 
 LispObject* GcdInteger(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment);
 
+/// The sum, difference, product and quotient of two numbers at the
+/// current precision, as MathAdd, MathSubtract, MathMultiply and
+/// MathDivide give them, or nullptr if either is not a number.
+LispObject* AddNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment);
+LispObject* SubtractNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment);
+LispObject* MultiplyNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment);
+LispObject* DivideNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment);
+
 LispObject* SinFloat(LispObject* int1, LispEnvironment& aEnvironment,int aPrecision);
 LispObject* CosFloat(LispObject* int1, LispEnvironment& aEnvironment,int aPrecision);
 LispObject* TanFloat(LispObject* int1, LispEnvironment& aEnvironment,int aPrecision);
@@ -61,6 +72,8 @@ public: //constructors
     // assign from a platform type
   void SetTo(long value);
   inline void SetTo(int value) { SetTo(long(value)); };
+  /// assign an integer, giving the number a precision in bits and its mantissa a precision in decimal digits
+  void SetTo(std::int64_t aValue, int aPrecision, int aMantissaPrecision);
   void SetTo(double value);
 public: // Convert back to other types
   /// ToString : return string representation of number in aResult to given precision (base digits)
@@ -128,6 +141,9 @@ private:
   }
 public:
   unsigned iReferenceCount;
+
+  static void* operator new(std::size_t size) { return Arena::Allocate(size); }
+  static void operator delete(void* object, std::size_t size) { Arena::Free(object, size); }
 private:
   int iPrecision;
 
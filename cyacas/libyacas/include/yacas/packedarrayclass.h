@@ -0,0 +1,126 @@
+/** \file packedarrayclass.h
+ *  Arrays of machine numbers.
+ *
+ *  A packed array holds either integers of at most 62 bits or doubles,
+ *  contiguously, so that elementwise arithmetic, sums and dot products
+ *  run in plain loops the compiler can vectorize, without evaluating
+ *  anything per element.
+ */
+
+#ifndef YACAS_PACKEDARRAYCLASS_H
+#define YACAS_PACKEDARRAYCLASS_H
+
+#include "lispobject.h"
+#include "genericobject.h"
+
+#include <cstdint>
+#include <vector>
+
+class LispEnvironment;
+
+class PackedArrayClass final: public GenericClass
+{
+public:
+    enum Type { Integer, Float };
+
+    /// Integers held in integer arrays are smaller than this in absolute
+    /// value, so that sums and differences of two fit in a machine word.
+    static const std::int64_t IntegerLimit = std::int64_t(1) << 62;
+
+    explicit PackedArrayClass(std::vector<std::int64_t>&& aIntegers);
+    explicit PackedArrayClass(std::vector<double>&& aFloats);
+    const char* TypeName() const override;
+
+    Type GetType() const;
+    std::size_t Size() const;
+
+    const std::vector<std::int64_t>& Integers() const;
+    const std::vector<double>& Floats() const;
+
+    /// The element aItem, counting from 1
+    LispObject* GetElement(LispEnvironment& aEnvironment, std::size_t aItem) const;
+
+    /// The type of array the elements of a list pack into, if they
+    /// are all numbers
+    static bool Packable(LispEnvironment& aEnvironment, LispObject* aList, Type& aType);
+
+    /// Pack the elements of a list, which must be packable, and which
+    /// must not overflow when they are packed as floats
+    static PackedArrayClass* FromList(LispEnvironment& aEnvironment, LispObject* aList);
+
+    LispPtr ToList(LispEnvironment& aEnvironment) const;
+
+    /// An array of aSize copies of the number aNumber, or nullptr if it
+    /// is not a number
+    static PackedArrayClass* Fill(LispEnvironment& aEnvironment, LispObject* aNumber, std::size_t aSize);
+
+    enum Operation { Add, Subtract, Multiply, Divide };
+
+    /// Apply aOperation to the elements of aX and aY, which must have
+    /// the same size. Quotients are floats, and integer results which
+    /// do not fit throw an error.
+    static PackedArrayClass* Elementwise(Operation aOperation, const PackedArrayClass& aX, const PackedArrayClass& aY);
+
+    /// The sum of the elements, exact for integer arrays
+    LispObject* Sum(LispEnvironment& aEnvironment) const;
+
+    /// The dot product with aOther, which must have the same size,
+    /// exact for integer arrays
+    LispObject* Dot(LispEnvironment& aEnvironment, const PackedArrayClass& aOther) const;
+
+private:
+    /// The elements as floats
+    std::vector<double> AsFloats() const;
+
+    Type iType;
+    std::vector<std::int64_t> iIntegers;
+    std::vector<double> iFloats;
+};
+
+inline
+PackedArrayClass::PackedArrayClass(std::vector<std::int64_t>&& aIntegers):
+    iType(Integer),
+    iIntegers(std::move(aIntegers)),
+    iFloats()
+{
+}
+
+inline
+PackedArrayClass::PackedArrayClass(std::vector<double>&& aFloats):
+    iType(Float),
+    iIntegers(),
+    iFloats(std::move(aFloats))
+{
+}
+
+inline
+const char* PackedArrayClass::TypeName() const
+{
+    return "\"PackedArray\"";
+}
+
+inline
+PackedArrayClass::Type PackedArrayClass::GetType() const
+{
+    return iType;
+}
+
+inline
+std::size_t PackedArrayClass::Size() const
+{
+    return iType == Integer ? iIntegers.size() : iFloats.size();
+}
+
+inline
+const std::vector<std::int64_t>& PackedArrayClass::Integers() const
+{
+    return iIntegers;
+}
+
+inline
+const std::vector<double>& PackedArrayClass::Floats() const
+{
+    return iFloats;
+}
+
+#endif
@@ -0,0 +1,36 @@
+/** \file parallel.h
+ *  Applying a function to the elements of a list in a pool of
+ *  environments, for ParallelMap.
+ *
+ *  The calling environment is one of the pool; the others are cloned
+ *  from it through a snapshot, so they have its rules and globals but
+ *  not its local variables, and each evaluates in a thread of its own.
+ *  The clones are kept for the calls to come, and made again only when
+ *  the rules, operators or precision of the calling environment have
+ *  changed; its globals are copied into them again when they may have.
+ *  The function, the elements and the results are passed between the
+ *  environments in the form they take in a snapshot. Each environment
+ *  starts with a contiguous share of the elements, and one which runs
+ *  out takes half of what is left of the share of another.
+ *
+ *  What the function does besides returning a result, such as setting
+ *  globals or printing, is lost for the elements which are not done by
+ *  the calling environment, and which those are is not defined.
+ */
+
+#ifndef YACAS_PARALLEL_H
+#define YACAS_PARALLEL_H
+
+#include "lispobject.h"
+
+#include <cstddef>
+
+class LispEnvironment;
+
+/// The list of the results of applying \a aFunction, as Apply does, to
+/// each element of \a aList, in \a aEnvironment and up to \a aWorkers - 1
+/// clones of it. If \a aWorkers is 0 there are as many environments as
+/// the hardware runs threads at once.
+LispPtr ParallelMap(LispEnvironment& aEnvironment, LispObject* aFunction, LispObject* aList, std::size_t aWorkers);
+
+#endif
@@ -23,6 +23,8 @@ public:
 
   const char* TypeName() const override;
 
+  const YacasPatternPredicateBase& Matcher() const { return *iPatternMatcher; }
+
 protected:
   YacasPatternPredicateBase* iPatternMatcher;
 };
@@ -14,11 +14,14 @@
 /// to use these variables).
 
 
+#include "arena.h"
 #include "lisptype.h"
 #include "lispenvironment.h"
 #include "noncopyable.h"
 #include "numbers.h"
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 /// Abstract class for matching one argument to a pattern.
@@ -45,6 +48,8 @@ public:
     bool ArgumentMatches(LispEnvironment& aEnvironment,
                          LispPtr& aExpression,
                          LispPtr* arguments) const override;
+
+    const LispString* String() const { return iString; }
 protected:
     const LispString* iString;
 };
@@ -84,6 +89,8 @@ public:
         LispPtr& aExpression,
         LispPtr* arguments) const override;
 
+    const std::vector<const YacasParamMatcherBase*>& Matchers() const { return iMatchers; }
+
 protected:
     std::vector<const YacasParamMatcherBase*> iMatchers;
 };
@@ -146,7 +153,7 @@ public:
     /// The function MakePatternMatcher() is called for every argument
     /// in \a aPattern, and the resulting pattern matchers are
     /// collected in #iParamMatchers. Additionally, \a aPostPredicate
-    /// is copied, and the copy is added to #iPredicates.
+    /// is added to #iPredicates, unless it is \c True.
     YacasPatternPredicateBase(LispEnvironment& aEnvironment,
                               LispPtr& aPattern,
                               LispPtr& aPostPredicate);
@@ -156,14 +163,11 @@ public:
 
     /// Try to match the pattern against \a aArguments.
     /// First, every argument in \a aArguments is matched against the
-    /// corresponding YacasParamMatcherBase in #iParamMatches. If any
-    /// match fails, Matches() returns false. Otherwise, a temporary
-    /// LispLocalFrame is constructed, then SetPatternVariables() and
-    /// CheckPredicates() are called, and then the LispLocalFrame is
-    /// immediately deleted. If CheckPredicates() returns false, this
-    /// function also returns false. Otherwise, SetPatternVariables()
-    /// is called again, but now in the current LispLocalFrame, and
-    /// this function returns true.
+    /// corresponding YacasParamMatcherBase in #iParamMatches, which
+    /// store the values of the pattern variables in
+    /// LispEnvironment::iPatternBindings. If any match fails,
+    /// Matches() returns false. Otherwise SetIfPredicatesHold()
+    /// decides.
     bool Matches(LispEnvironment& aEnvironment, LispPtr& aArguments);
 
     /// Try to match the pattern against \a aArguments.
@@ -171,6 +175,13 @@ public:
     /// but differs in the type of the arguments.
     bool Matches(LispEnvironment& aEnvironment, LispPtr* aArguments);
 
+    /// The matchers for the arguments, one for every parameter.
+    const std::vector<const YacasParamMatcherBase*>& ParamMatchers() const { return iParamMatchers; }
+
+    /// The pattern and postpredicate the matcher was constructed from.
+    const LispPtr& Pattern() const { return iPattern; }
+    const LispPtr& PostPredicate() const { return iPostPredicate; }
+
 protected:
     /// Construct a pattern matcher out of a Lisp expression.
     /// The result of this function depends on the value of \a aPattern:
@@ -200,6 +211,14 @@ protected:
     int LookUp(const LispString* aVariable);
 
 protected:
+    /// Set the pattern variables, whose values are the last ones in
+    /// LispEnvironment::iPatternBindings, as locals of the current
+    /// frame if all predicates hold for them. The predicates are
+    /// evaluated in a frame of their own, which is merged into the
+    /// current one on success, so the locals are only set once.
+    /// Without predicates no frame is needed.
+    bool SetIfPredicatesHold(LispEnvironment& aEnvironment);
+
     /// Set local variables corresponding to the pattern variables.
     /// This function goes through the #iVariables array. A local
     /// variable is made for every entry in the array, and the
@@ -222,7 +241,55 @@ protected:
 
     /// List of predicates which need to be true for a match.
     std::vector<LispPtr> iPredicates;
+
+    LispPtr iPattern;
+    LispPtr iPostPredicate;
 };
 
+/// Finds the patterns which can match arguments, for many patterns at
+/// once.
+///
+/// The matchers of each pattern are added as a path, in which atoms,
+/// numbers and lists of a given length each take a step, and pattern
+/// variables skip an argument whatever it is. Paths which start alike
+/// share their steps, so arguments are compared with all patterns in
+/// one traversal. The tree does not compare numbers by value, nor
+/// variables which appear twice, nor does it check the predicates, so
+/// a pattern it finds may still fail to match.
+class DiscriminationTree: NonCopyable {
+public:
+    DiscriminationTree();
+    ~DiscriminationTree();
+
+    /// Add a pattern, to be found as \a aValue.
+    void Add(const std::vector<const YacasParamMatcherBase*>& aMatchers, std::size_t aValue);
+
+    typedef std::vector<std::size_t, ArenaAllocator<std::size_t>> Values;
+
+    /// Append the values of the patterns which can match the \a aCount
+    /// arguments in \a aArguments to \a aValues, in no particular order.
+    void Find(LispPtr* aArguments, std::size_t aCount, Values& aValues) const;
+
+private:
+    struct Node {
+        std::unique_ptr<Node> iVariable;
+        std::unique_ptr<Node> iNumber;
+        std::unordered_map<const LispString*, std::unique_ptr<Node>> iAtoms;
+        /// by length
+        std::unordered_map<std::size_t, std::unique_ptr<Node>> iLists;
+        std::size_t iLongestList;
+        std::vector<std::size_t> iValues;
+
+        Node(): iLongestList(0) {}
+    };
+
+    static Node* Step(Node* aNode, const YacasParamMatcherBase* aMatcher);
+
+    static void Find(const Node* aNode, std::vector<LispObject*>& aPending, Values& aValues);
+
+    Node iRoot;
+    /// arguments still to be compared, last first
+    mutable std::vector<LispObject*> iPending;
+};
 
 #endif
@@ -0,0 +1,83 @@
+/** \file snapshot.h
+ *  Saving and restoring the definitions of an environment, and
+ *  compiled scripts.
+ *
+ *  A snapshot holds what the scripts loaded into an environment have
+ *  defined: the rule bases with their rules, global variables,
+ *  operators, protected symbols and definition files, together with
+ *  the precision and a fingerprint of every script and def file that
+ *  was read. Restoring a snapshot into a fresh environment gives the
+ *  same state as loading the scripts again, without tokenizing,
+ *  parsing and evaluating them.
+ *
+ *  The objects are written as trees of interned symbols, numbers and
+ *  lists; numbers are restored at the precision of the snapshot.
+ *
+ *  A compiled script holds the expressions parsed from a script in the
+ *  same form, so that loading it only has to evaluate them. It is only
+ *  used for the text it was compiled from, which it records the size and
+ *  fingerprint of, and as parsing depends on the operators defined, when
+ *  its tokens are defined as operators the same way as when it was
+ *  compiled.
+ */
+
+#ifndef YACAS_SNAPSHOT_H
+#define YACAS_SNAPSHOT_H
+
+#include "lispobject.h"
+#include "noncopyable.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+class LispEnvironment;
+class LispInput;
+
+/// Write a snapshot of \a aEnvironment to \a aOutput. If \a aClone is
+/// true the snapshot is only for cloning the environment in the same
+/// process, and the files it was made from are not read.
+void SaveSnapshot(LispEnvironment& aEnvironment, std::ostream& aOutput, bool aClone = false);
+
+/// Restore a snapshot read from \a aInput into \a aEnvironment, in which
+/// no functions may have been defined yet. Returns false, leaving the
+/// environment untouched, if the input is not a snapshot made by this
+/// version of yacas, or if one of the files it was made from cannot be
+/// found in the input directories or has changed since. If \a aClone is
+/// true the files are not checked, as for a snapshot saved with
+/// \a aClone in the same process; other snapshots fail the check.
+bool LoadSnapshot(LispEnvironment& aEnvironment, std::istream& aInput, bool aClone = false);
+
+/// Write \a aExpression in the form objects take in a snapshot, so
+/// that it can be read into another environment of the same process.
+std::string SaveExpression(LispObject* aExpression);
+
+/// Read an expression written by SaveExpression into \a aEnvironment,
+/// at its precision.
+LispPtr LoadExpression(LispEnvironment& aEnvironment, const std::string& aData);
+
+/// Collects the expressions read from a script, to save them as a
+/// compiled script. It must be constructed before the script is read,
+/// and records how the operators in \a aSource, which reads
+/// \a aSourceText, are defined at that point, leaving it rewound.
+class ScriptCompiler: NonCopyable {
+public:
+    ScriptCompiler(LispEnvironment& aEnvironment, LispInput& aSource, const std::string& aSourceText);
+    ~ScriptCompiler();
+
+    /// Add an expression, before it is evaluated
+    void Add(LispObject* aExpression);
+    void Save(std::ostream& aOutput);
+
+private:
+    class Expressions;
+    std::unique_ptr<Expressions> iExpressions;
+};
+
+/// Evaluate the compiled script read from \a aInput, one expression at
+/// a time. Returns false, without evaluating anything, if the input is
+/// not a script compiled by this version of yacas from \a aSourceText,
+/// or if one of its tokens is defined differently as an operator now.
+bool LoadCompiledScript(LispEnvironment& aEnvironment, std::istream& aInput, const std::string& aSourceText);
+
+#endif
@@ -9,6 +9,7 @@
 
 // Prototypes
 class LispHashTable;
+class ScriptCompiler;
 
 bool InternalIsList(const LispEnvironment& env, const LispPtr& aPtr);
 bool InternalIsString(const LispString* aOriginal);
@@ -23,6 +24,9 @@ void InternalAssociate(LispPtr& aResult, const LispPtr& aKey,
 
 void InternalReverseList(LispPtr& aResult, const LispPtr& aOriginal);
 void InternalFlatCopy(LispPtr& aResult, const LispPtr& aOriginal);
+/// Copy an expression, including all the lists in it, so that nothing is
+/// shared with the original.
+void InternalDeepCopy(LispPtr& aResult, LispPtr& aOriginal);
 std::size_t InternalListLength(const LispPtr& aOriginal);
 
 bool InternalStrictTotalOrder(const LispEnvironment& env,
@@ -33,6 +37,16 @@ bool InternalEquals(const LispEnvironment& aEnvironment,
                     const LispPtr& aExpression1,
                     const LispPtr& aExpression2);
 
+/// Structural hash of an expression. Expressions which InternalEquals()
+/// finds equal have the same hash if it is exact, that is if the lowest
+/// bit is set: floating point numbers, which are equal only to within
+/// the precision, make it inexact. The hashes of lists are cached in
+/// them until the environment invalidates its hashes.
+std::size_t InternalHash(const LispEnvironment& aEnvironment,
+                         const LispPtr& aExpression);
+
+inline bool InternalHashIsExact(std::size_t aHash) { return aHash & 1; }
+
 
 inline LispPtr& Argument(LispPtr& cur, int n);
 
@@ -44,7 +58,7 @@ inline bool IsTrue(LispEnvironment& aEnvironment, const LispPtr& aExpression);
 inline bool IsFalse(LispEnvironment& aEnvironment, const LispPtr& aExpression);
 inline void InternalNot(LispPtr& aResult, LispEnvironment& aEnvironment, LispPtr& aExpression);
 
-void DoInternalLoad(LispEnvironment& aEnvironment,LispInput* aInput);
+void DoInternalLoad(LispEnvironment& aEnvironment,LispInput* aInput, ScriptCompiler* aCompiler = nullptr);
 void InternalLoad(LispEnvironment& aEnvironment, const std::string& aFileName);
 void InternalUse(LispEnvironment& aEnvironment, const std::string& aFileName);
 void InternalApplyString(LispEnvironment& aEnvironment, LispPtr& aResult,
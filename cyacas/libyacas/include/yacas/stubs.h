@@ -1,4 +1,3 @@
-
 /** \file stubs.h interface to platform-dependent functions
  */
 
@@ -7,24 +6,12 @@
 
 #include <cstddef>
 
-#ifdef NO_GLOBALS
-  void* PlatStubAlloc(std::size_t aNrBytes);
-  void* PlatStubReAlloc(void* aOrig, std::size_t aNrBytes);
-  void PlatStubFree(void* aOrig);
-
-  #define PlatAlloc PlatStubAlloc
-  #define PlatReAlloc PlatStubReAlloc
-  #define PlatFree PlatStubFree
-#else
-  void* PlatObAlloc(std::size_t nbytes);
-  void PlatObFree(void *p);
-  void* PlatObReAlloc(void *p, std::size_t nbytes);
-  void PlatObSetThreadSafe(bool);
+void* PlatStubAlloc(std::size_t aNrBytes);
+void* PlatStubReAlloc(void* aOrig, std::size_t aNrBytes);
+void PlatStubFree(void* aOrig);
 
-  #define PlatAlloc(nr)        PlatObAlloc(nr)
-  #define PlatReAlloc(orig,nr) PlatObReAlloc(orig, nr)
-  #define PlatFree(orig)       PlatObFree(orig)
-
-#endif
+#define PlatAlloc PlatStubAlloc
+#define PlatReAlloc PlatStubReAlloc
+#define PlatFree PlatStubFree
 
 #endif
@@ -12,6 +12,14 @@ class SubstBehaviourBase {
 public:
     virtual ~SubstBehaviourBase() = default;
     virtual bool Matches(LispPtr& aResult, LispPtr& aElement) = 0;
+
+    /** Whether the result may share the subexpressions in which nothing
+     *  is substituted with the source. Expressions which are about to be
+     *  evaluated can, as evaluation doesn't change them; the caller then
+     *  has to copy the result of the evaluation, which may hold parts of
+     *  the source, before handing it out.
+     */
+    virtual bool ShareUnchanged() const { return true; }
 };
 
 /** main routine that can perform substituting of expressions
@@ -29,6 +37,10 @@ public:
     SubstBehaviour(LispEnvironment& aEnvironment,LispPtr& aToMatch,
                   LispPtr& aToReplaceWith);
     bool Matches(LispPtr& aResult, LispPtr& aElement) override;
+    /** The result is a fresh copy, destructive changes to it must not
+     *  show up in the source.
+     */
+    bool ShareUnchanged() const override { return false; }
 private:
     LispEnvironment& iEnvironment;
     LispPtr& iToMatch;
@@ -4,6 +4,7 @@
 #ifndef YACAS_YACAS_H
 #define YACAS_YACAS_H
 
+#include "arena.h"
 #include "lispstring.h"
 #include "stringio.h"
 #include "tokenizer.h"
@@ -18,7 +19,9 @@
 #include "lispuserfunc.h"
 #include "noncopyable.h"
 
+#include <memory>
 #include <sstream>
+#include <vector>
 
 
 /// The default environment for a Yacas session.
@@ -32,8 +35,16 @@ class DefaultYacasEnvironment: NonCopyable
 public:
   explicit DefaultYacasEnvironment(std::ostream&);
   LispEnvironment& getEnv() {return iEnvironment;}
+  const LispEnvironment& getEnv() const {return iEnvironment;}
+  Arena& getArena() {return arena;}
 
 private:
+  // first, so that it is constructed before and destroyed after all
+  // the objects allocated from it
+  Arena arena;
+  // makes the arena current while the other members are constructed
+  std::unique_ptr<Arena::Scope> constructing;
+
   std::ostream& output;
   LispHashTable hash;
   LispPrinter printer;
@@ -62,12 +73,20 @@ public:
 /// The Yacas engine.
 /// This is the only class that applications need to use. It can
 /// evaluate Yacas expressions. Every instance has its own Yacas
-/// environment, in which the expressions are evaluated.
+/// environment, in which the expressions are evaluated, and its own
+/// arena, from which the objects of the environment are allocated.
 
 
 
 class CYacas {
 public:
+    /// The outcome of evaluating one expression of a batch.
+    struct BatchResult {
+        std::string result;  ///< as returned by Result()
+        std::string error;   ///< as returned by Error()
+        double seconds;      ///< wall-clock time taken
+    };
+
     /// Constructor
     explicit CYacas(std::ostream&);
 
@@ -78,9 +97,36 @@ public:
     /// First, \p aExpression is parsed by an InfixParser. Then it is
     /// evaluated in the underlying Lisp environment. Finally, the
     /// result is printed to #iResultOutput via the pretty printer or,
-    /// if this is not defined, via an InfixPrinter.
+    /// if this is not defined, via an InfixPrinter. The arena of the
+    /// environment is current on the calling thread meanwhile.
+    /// Each call is limited by the budget set with SetBudget(); an
+    /// evaluation which goes over it fails with LispErrBudgetExceeded,
+    /// and the environment can be used again afterwards.
     void Evaluate(const std::string& aExpression);
 
+    /// Evaluate each of \p aExpressions in turn, as by Evaluate(),
+    /// and return their outcomes in the same order. Each is limited by
+    /// the budget on its own.
+    std::vector<BatchResult> EvaluateBatch(const std::vector<std::string>& aExpressions);
+
+    /// Evaluate \p aExpressions across the environments \p aWorkers,
+    /// each of which evaluates in a thread of its own, taking the next
+    /// expression not yet taken whenever it is done with one, and
+    /// return the outcomes in the order of the expressions. The
+    /// environments are set up, with the scripts loaded, by the caller,
+    /// so that this cost is paid once per environment rather than once
+    /// per expression; which environment evaluates an expression is not
+    /// defined, so the expressions should be independent.
+    static std::vector<BatchResult> EvaluateBatch(
+        const std::vector<CYacas*>& aWorkers,
+        const std::vector<std::string>& aExpressions);
+
+    /// Set the limits on each evaluation by Evaluate().
+    void SetBudget(const EvaluationBudget& aBudget);
+
+    /// Return the limits on each evaluation by Evaluate().
+    const EvaluationBudget& Budget() const;
+
     /// Return the result of the expression.
     /// This is stored in #iResult.
     const std::string& Result() const;
@@ -93,6 +139,7 @@ public:
     bool IsError() const;
 
 private:
+    void Evaluate(const std::string& aExpression, BatchResult& aResult);
 
     /// The underlying Yacas environment
     DefaultYacasEnvironment environment;
@@ -113,6 +160,18 @@ const std::string& CYacas::Error() const
   return _error;
 }
 
+inline
+void CYacas::SetBudget(const EvaluationBudget& aBudget)
+{
+    environment.getEnv().iBudget = aBudget;
+}
+
+inline
+const EvaluationBudget& CYacas::Budget() const
+{
+    return environment.getEnv().iBudget;
+}
+
 inline
 bool CYacas::IsError() const
 {
@@ -18,6 +18,10 @@
 void BaseAddFull(ANumber& aResult, ANumber& a1, ANumber& a2);
 void BaseSubtract(ANumber& aResult, ANumber& a1, ANumber& a2);
 void BaseMultiplyFull(ANumber& aResult, ANumber& a1, ANumber& a2);
+void BaseToDigits(std::string& aDigits, const PlatWord* aWords, std::size_t aSize, int aBase);
+void BaseFromDigits(ANumber& aResult, const std::string& aDigits, int aBase);
+void BaseDivideFull(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a2);
+void BaseSqrtFull(ANumber& aResult, const ANumber& N);
 void BaseSqrt(ANumber& aResult, const ANumber& N);
 
 void ANumber::Print(std::ostream& os, const std::string& prefix) const
@@ -161,20 +165,12 @@ void ANumber::SetTo(const char* aString,int aBase)
     if (endFloatIndex-endIntIndex-1 > iPrecision)
       iPrecision = endFloatIndex-endIntIndex-1;
 
-    // Go to least significant digit first
-    const char* ptr = aString + endIntIndex-1;
-
     // Now parse the integer part of the number.
-    ANumber factor2(iPrecision);
-    factor2[0] = 1;
-    while (ptr >= endptr)
+    if (aString + endIntIndex > endptr)
     {
-        ANumber term(iPrecision);
-        term.CopyFrom(factor2);
-        WordBaseTimesInt(term, DigitIndex(*ptr));
-        WordBaseAdd(*this,term);
-        WordBaseTimesInt(factor2, aBase);
-        ptr--;
+        std::string digits(endptr, aString + endIntIndex);
+        std::transform(digits.begin(), digits.end(), digits.begin(), &DigitIndex);
+        BaseFromDigits(*this, digits, aBase);
     }
 
     //Parse the fraction
@@ -278,9 +274,9 @@ void Multiply(ANumber& aResult, ANumber& a1, ANumber& a2)
     a2.DropTrailZeroes();
 
     if (a1.iExp || a1.iTensExp)
-        NormalizeFloat(a1,WordDigits(a1.iPrecision, 10));
+        NormalizeFloat(a1,a1.iPrecision);
     if (a2.iExp || a2.iTensExp)
-        NormalizeFloat(a2,WordDigits(a2.iPrecision, 10));
+        NormalizeFloat(a2,a2.iPrecision);
 
     // this does some additional removing, as for the multiplication we don't need
     // any trailing zeroes at all, regardless of the value of iExp
@@ -313,9 +309,11 @@ void Multiply(ANumber& aResult, ANumber& a1, ANumber& a2)
     a1.Expand();
     a2.Expand();
 
+    // a float stays normalized even if its fraction turns out to be zero
+    const bool isFloat = aResult.iExp || aResult.iTensExp;
     aResult.DropTrailZeroes();
-    if (aResult.iExp || aResult.iTensExp)
-        NormalizeFloat(aResult,WordDigits(aResult.iPrecision, 10));
+    if (isFloat)
+        NormalizeFloat(aResult,aResult.iPrecision);
 }
 
 static void BalanceFractions(ANumber& a1, ANumber& a2)
@@ -373,9 +371,9 @@ void Add(ANumber& aResult, ANumber& a1, ANumber& a2)
 
     // if the numbers are float, make sure they are normalized
     if (a1.iExp || a1.iTensExp)
-        NormalizeFloat(a1,WordDigits(a1.iPrecision, 10));
+        NormalizeFloat(a1,a1.iPrecision);
     if (a2.iExp || a2.iTensExp)
-        NormalizeFloat(a2,WordDigits(a2.iPrecision, 10));
+        NormalizeFloat(a2,a2.iPrecision);
 
     //Two positive numbers
     BalanceFractions(a1, a2);
@@ -441,7 +439,7 @@ void Add(ANumber& aResult, ANumber& a1, ANumber& a2)
       if (aResult.iPrecision < a1.iPrecision)
         aResult.iPrecision = a1.iPrecision;
 
-      NormalizeFloat(aResult,WordDigits(aResult.iPrecision, 10));
+      NormalizeFloat(aResult,aResult.iPrecision);
     }
 }
 
@@ -523,9 +521,9 @@ bool LessThan(ANumber& a1, ANumber& a2)
 
     // if the numbers are float, make sure they are normalized
     if (a1.iExp || a1.iTensExp)
-        NormalizeFloat(a1,WordDigits(a1.iPrecision, 10));
+        NormalizeFloat(a1,a1.iPrecision);
     if (a2.iExp || a2.iTensExp)
-        NormalizeFloat(a2,WordDigits(a2.iPrecision, 10));
+        NormalizeFloat(a2,a2.iPrecision);
 
     BalanceFractions(a1, a2);
     if (a1.IsNegative() && !a2.IsNegative())
@@ -565,39 +563,12 @@ void  ANumberToString(LispString& aResult, ANumber& aNumber, int aBase, bool aFo
         number.CopyFrom(aNumber);
 
         assert(aBase<=36);
-        // Reset number
-        aResult.clear();
-        aResult.push_back(0);
-
-        // Create the number
-        std::string factor2;
-        BaseIntNumber(factor2, 1, aBase);
-
-        std::string factor3;
-        BaseIntNumber(factor3, WordBase, aBase);
-
         assert(number.iExp >= 0);
 
+        // Create the number
         const std::size_t ns = number.size();
-        for (std::size_t i=number.iExp; i < ns; ++i)
-        {
-            //aResult = aResult + number[i] * factor2
-            std::string term;
-            BaseIntNumber(term, number[i], aBase);
-            BaseAddMultiply(aResult, term, factor2, aBase);
-
-            //factor2 = factor2*factor3
-            term.swap(factor2);
-
-            BaseMultiply(factor2, term, factor3, aBase);
-        }
-
-        //Remove trailing zeroes (most significant side)
-        while (aResult.size() > 1 && aResult.back() == 0)
-            aResult.pop_back();
-        nr = aResult.size();
-
-        std::reverse(aResult.begin(), aResult.end());
+        const std::size_t ne = std::min<std::size_t>(number.iExp, ns);
+        BaseToDigits(aResult, number.data() + ne, ns - ne, aBase);
 
         // Get the fraction
         number.resize(number.iExp, 0);
@@ -697,13 +668,6 @@ void BaseSubtract(ANumber& aResult, ANumber& a1, ANumber& a2)
     BaseSubtract(aResult, a2,0);
 }
 
-void BaseMultiplyFull(ANumber& aResult, ANumber& a1, ANumber& a2)
-{
-    // Initialize result
-    WordBaseMultiply(aResult,a1,a2);
-}
-
-
 bool BaseGreaterThan(const ANumber& a1, const ANumber& a2)
 {
     const int nr1 = a1.size();
@@ -809,7 +773,7 @@ void BaseShiftLeft(ANumber& a, int aNrBits)
     int otherSideBits = WordBits-residue;
 
     // Bit mask: bits that are going to be shifted out of each word.
-    int bitMask = ((1L<<residue)-1)<<otherSideBits;
+    PlatDoubleWord bitMask = ((((PlatDoubleWord)1)<<residue)-1)<<otherSideBits;
 
     int i;
     int nr = a.size();
@@ -927,7 +891,7 @@ void BaseDivide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a
     aQuotient.resize(m+1);
 
     //D1:
-    PlatDoubleWord d = WordBase/(a2[n-1]+1);
+    PlatDoubleWord d = WordBase/(static_cast<PlatDoubleWord>(a2[n-1])+1);
     WordBaseTimesInt(a1, d);
     WordBaseTimesInt(a2, d);
     a1.push_back(0);
@@ -942,8 +906,10 @@ void BaseDivide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a
         PlatDoubleWord q = (a1[j+n]*WordBase+a1[j+n-1])/a2[n-1];
         PlatDoubleWord r = (a1[j+n]*WordBase+a1[j+n-1])%a2[n-1];
 
+        // The products below fit in a PlatDoubleWord only as long as
+        // q and r are less than WordBase, so test those first.
     REDO:
-        if (q == WordBase || q*a2[n-2] > WordBase*r+a1[j+n-2])
+        if (q >= WordBase || q*a2[n-2] > (r<<WordBits)+a1[j+n-2])
         {
             q = q - 1;
             r = r + a2[n-1];
@@ -1055,7 +1021,7 @@ void IntegerDivide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber
         aQuotient.iExp = a1.iExp-a2.iExp;
         aQuotient.iTensExp = a1.iTensExp-a2.iTensExp;
         // Divide the mantissas
-        WordBaseDivide(aQuotient, aRemainder, a1, a2);
+        BaseDivideFull(aQuotient, aRemainder, a1, a2);
     }
 
     // Correct for signs
@@ -1071,19 +1037,100 @@ void IntegerDivide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber
     }
 }
 
-void NormalizeFloat(ANumber& a2, int digitsNeeded)
+// a *= 10^k
+static void BaseTimesPowerOfTen(ANumber& a, int k)
 {
+    ANumber power(0), factor(0), product(0);
+    power[0] = 1;
+    factor[0] = 10;
+
+    for (;;) {
+        if (k & 1) {
+            BaseMultiplyFull(product, power, factor);
+            power.swap(product);
+            while (power.back() == 0)
+                power.pop_back();
+        }
+        k >>= 1;
+        if (!k)
+            break;
+        BaseMultiplyFull(product, factor, factor);
+        factor.swap(product);
+        while (factor.back() == 0)
+            factor.pop_back();
+    }
+
+    BaseMultiplyFull(product, a, power);
+    while (product.size() > 1 && product.back() == 0)
+        product.pop_back();
+    a.assign(product.begin(), product.end());
+}
+
+// Whether the mantissa of a is at least 11*2^aBits
+static bool MantissaExceeds(const ANumber& a, int aBits)
+{
+  int n = a.size();
+  while (n > 1 && a[n-1] == 0)
+    n--;
+
+  int bits = (n-1)*WordBits;
+  for (PlatWord top = a[n-1]; top; top >>= 1)
+    bits++;
+
+  if (bits != aBits + 4)
+    return bits > aBits + 4;
+
+  // the mantissa has four bits above aBits; compare them to 11
+  const int i = aBits / WordBits;
+  PlatDoubleWord high = a[i];
+  if (i + 1 < n)
+    high |= PlatDoubleWord(a[i+1]) << WordBits;
+  return (high >> (aBits % WordBits)) >= 11;
+}
+
+void NormalizeFloat(ANumber& a2, int aPrecision)
+{
+  const int digitsNeeded = WordDigits(aPrecision, 10);
+
+  // The mantissa is cut down to the bits WordDigits gives for 16-bit
+  // words, so that the decimal digits a float keeps do not depend on the
+  // word size. A fraction in wider words may hold more bits than that,
+  // which the integer part gets back: otherwise numbers like 18.87 had a
+  // digit moved into iTensExp, and lost it when printed.
+  const int bitsNeeded = 16*((aPrecision*4 + 32)/16);
+
   if (a2.iExp - digitsNeeded > 0)
   {
     a2.erase(a2.begin(), a2.begin() + a2.iExp - digitsNeeded);
     a2.iExp -= (a2.iExp-digitsNeeded);
   }
 
-  const std::size_t min = std::max(1+digitsNeeded, a2.iExp+1);
-  
+  const int bits = std::max(bitsNeeded, int(a2.iExp*WordBits + WordBits - 16));
+  const std::size_t min = a2.iExp+1;
+
   std::size_t n = a2.size();
-  while (n > min ||
-          (n == min && a2.back() > 10))
+
+  // Remove whole words' worth of digits at a time while that certainly
+  // does not go too far: dividing by a power of ten below the word base
+  // drops at most one word.
+  PlatDoubleWord tens = 10;
+  int nrTens = 1;
+  while (tens * 10 < WordBase)
+  {
+    tens *= 10;
+    nrTens++;
+  }
+  while (n > min + 1 && MantissaExceeds(a2, bits + WordBits))
+  {
+    PlatDoubleWord carry = 0;
+    BaseDivideInt(a2, tens, WordBase, carry);
+    if (a2.back() == 0)
+        a2.pop_back();
+    a2.iTensExp += nrTens;
+    n = a2.size();
+  }
+
+  while ((n > min || (n == min && a2.back() > 10)) && MantissaExceeds(a2, bits))
   {
     PlatDoubleWord carry = 0;
     BaseDivideInt(a2, 10, WordBase,carry);
@@ -1104,7 +1151,7 @@ void Divide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a2)
     // by WordDigits-(a1.iExp-a2.iExp) = WordDigits+a2.iExp-a1.iExp
     int digitsNeeded = WordDigits(aQuotient.iPrecision, 10);
 
-    NormalizeFloat(a2,digitsNeeded);
+    NormalizeFloat(a2,aQuotient.iPrecision);
 
     const int toadd = a2.iExp-a1.iExp;
     PlatWord zero=0;
@@ -1115,6 +1162,23 @@ void Divide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a2)
 
     if (!a1.IsZero()) {
         const std::size_t n = a2.size();
+
+        // Most of the factors of ten can be applied in one multiplication:
+        // as long as a1 is below 2^((n+digitsNeeded-1)*WordBits) the loop
+        // below would not stop anyway.
+        if (a1.back() != 0) {
+            int bits = static_cast<int>(a1.size() - 1) * WordBits;
+            for (PlatWord top = a1.back(); top; top >>= 1)
+                bits++;
+
+            const int room = static_cast<int>(n + digitsNeeded - 1) * WordBits - bits;
+            if (room > 4 * static_cast<int>(WordBits)) {
+                const int tens = static_cast<int>(room / 3.33) + 1;
+                BaseTimesPowerOfTen(a1, tens);
+                a1.iTensExp -= tens;
+            }
+        }
+
         while (a1.size()< n + digitsNeeded || a1.back() < a2.back()) {
             WordBaseTimesInt(a1, 10);
             a1.iTensExp--;
@@ -1123,7 +1187,7 @@ void Divide(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a2)
 
     IntegerDivide(aQuotient,aRemainder,a1,a2);
 
-    NormalizeFloat(aQuotient,digitsNeeded);
+    NormalizeFloat(aQuotient,aQuotient.iPrecision);
 }
 
 
@@ -1213,7 +1277,7 @@ void Sqrt(ANumber& aResult, ANumber& N)
     const int resultDigits = N.iExp/2;
     const int resultTensExp = N.iTensExp/2;
 
-    BaseSqrt(aResult, N);
+    BaseSqrtFull(aResult, N);
 
     aResult.iExp=resultDigits;
     aResult.iTensExp = resultTensExp;
@@ -1225,8 +1289,7 @@ void Sqrt(ANumber& aResult, ANumber& N)
  */
 bool Significant(ANumber& a)
 {
-    int significantDigits = WordDigits(a.iPrecision, 10);
-    NormalizeFloat(a,significantDigits);
+    NormalizeFloat(a,a.iPrecision);
     //hier
     int nrExt = (a.size()-a.iExp)*((WordBits)/3);
     if ((-a.iTensExp) > a.iPrecision+2+nrExt)
@@ -0,0 +1,287 @@
+/* Division and square roots of the mantissas of large arbitrary precision
+ * numbers.
+ *
+ * Long division and the bit by bit square root take time quadratic in the
+ * size of the operands. For large operands the quotient is instead taken
+ * from an approximate reciprocal of the divisor, which is computed with
+ * Newton's method at doubling precision, and the square root is refined
+ * with one Newton step per doubling of precision. Both then cost a small
+ * number of full size multiplications, and profit from the fast
+ * multiplication methods.
+ *
+ * The results are corrected at the end and are exact: the quotient and
+ * remainder satisfy a1 = q*a2 + r with 0 <= r < a2, and the square root
+ * is rounded down.
+ */
+
+#include "yacas/anumber.h"
+
+#include <cassert>
+
+void BaseMultiplyFull(ANumber& aResult, ANumber& a1, ANumber& a2);
+void BaseSqrt(ANumber& aResult, const ANumber& N);
+
+namespace {
+
+// Newton division is used when both the divisor and the quotient have
+// at least this many words
+const std::size_t NewtonDivideThreshold = 80;
+
+// Square roots of numbers of at least this many words are computed with
+// Newton steps
+const std::size_t NewtonSqrtThreshold = 8;
+
+// All numbers below are plain integers, trimmed to their highest non-zero
+// word but at least one word long.
+void Trim(ANumber& a)
+{
+    std::size_t n = a.size();
+    while (n > 1 && a[n - 1] == 0)
+        n--;
+    a.resize(n);
+}
+
+void Assign(ANumber& aResult, const ANumber& a, std::size_t aFrom = 0)
+{
+    if (aFrom < a.size())
+        aResult.assign(a.begin() + aFrom, a.end());
+    else
+        aResult.assign(1, 0);
+}
+
+// B^k, with B the word base
+void Power(ANumber& aResult, std::size_t k)
+{
+    aResult.assign(k + 1, 0);
+    aResult[k] = 1;
+}
+
+void ShiftDown(ANumber& a, std::size_t k)
+{
+    if (k < a.size())
+        a.erase(a.begin(), a.begin() + k);
+    else
+        a.assign(1, 0);
+}
+
+void ShiftUp(ANumber& a, std::size_t k)
+{
+    a.insert(a.begin(), k, 0);
+    Trim(a);
+}
+
+void Product(ANumber& aResult, ANumber& a, ANumber& b)
+{
+    BaseMultiplyFull(aResult, a, b);
+    Trim(aResult);
+}
+
+void Add(ANumber& a, const ANumber& b)
+{
+    WordBaseAdd(a, b);
+    Trim(a);
+}
+
+// a -= b, for a >= b
+void Sub(ANumber& a, ANumber& b)
+{
+    BaseSubtract(a, b, 0);
+    Trim(a);
+}
+
+void AddWord(ANumber& a, PlatWord w)
+{
+    ANumber b(0);
+    b[0] = w;
+    Add(a, b);
+}
+
+void SubWord(ANumber& a, PlatWord w)
+{
+    ANumber b(0);
+    b[0] = w;
+    Sub(a, b);
+}
+
+void LongDivide(ANumber& q, ANumber& r, const ANumber& a, const ANumber& b)
+{
+    if (BaseLessThan(a, b)) {
+        q.assign(1, 0);
+        Assign(r, a);
+        return;
+    }
+
+    if (b.size() == 1) {
+        PlatDoubleWord carry;
+        Assign(q, a);
+        BaseDivideInt(q, b[0], WordBase, carry);
+        Trim(q);
+        r.assign(1, static_cast<PlatWord>(carry));
+        return;
+    }
+
+    // WordBaseDivide destroys its arguments
+    ANumber a1(0), a2(0);
+    Assign(a1, a);
+    Assign(a2, b);
+    WordBaseDivide(q, r, a1, a2);
+    Trim(q);
+    Trim(r);
+}
+
+// x = B^k/d, rounded down and then possibly a few units too small.
+void Reciprocal(ANumber& x, ANumber& d, std::size_t k)
+{
+    const std::size_t h = d.size();
+    assert(k >= h);
+
+    // number of words of the result, give or take one
+    const std::size_t l = k - h + 1;
+
+    if (h > l + 1) {
+        // Only the leading l+1 words of d matter. Rounding them up keeps
+        // the result from overshooting, and costs at most one unit.
+        const std::size_t s = h - l - 1;
+        ANumber top(0);
+        Assign(top, d, s);
+        AddWord(top, 1);
+        Reciprocal(x, top, k - s);
+        return;
+    }
+
+    if (l < NewtonDivideThreshold) {
+        ANumber power(0), remainder(0);
+        Power(power, k);
+        LongDivide(x, remainder, power, d);
+        return;
+    }
+
+    // Get about half the words of the result first, then let a Newton
+    // step x += x*(B^k - d*x)/B^k double their number. The error of the
+    // half size result is squared, so it ends up below a unit, and as
+    // the step approaches the reciprocal from below it never overshoots.
+    const std::size_t shift = l - (l / 2 + 2);
+    Reciprocal(x, d, k - shift);
+    ShiftUp(x, shift);
+
+    ANumber dx(0), e(0), correction(0);
+    Product(dx, d, x);
+    Power(e, k);
+    Sub(e, dx);
+    Product(correction, x, e);
+    ShiftDown(correction, k);
+    Add(x, correction);
+}
+
+void DivideWithRemainder(ANumber& q, ANumber& r, ANumber& a, ANumber& b)
+{
+    const std::size_t n = a.size();
+    const std::size_t m = b.size();
+
+    if (n < m || n - m + 1 < NewtonDivideThreshold || m < NewtonDivideThreshold) {
+        LongDivide(q, r, a, b);
+        return;
+    }
+
+    // Estimate the quotient from the leading words of a and b, using a
+    // divisor with about as many words as the quotient has.
+    const std::size_t l = n - m + 1;
+    const std::size_t s = m > l + 1 ? m - l - 1 : 0;
+
+    ANumber at(0), bt(0), x(0);
+    Assign(at, a, s);
+    Assign(bt, b, s);
+    Reciprocal(x, bt, n - s);
+    Product(q, at, x);
+    ShiftDown(q, n - s);
+
+    // The estimate is off by a few units at most; fix it up so the
+    // remainder comes out right.
+    ANumber qb(0);
+    Product(qb, q, b);
+    while (BaseLessThan(a, qb)) {
+        SubWord(q, 1);
+        Sub(qb, b);
+    }
+
+    Assign(r, a);
+    Sub(r, qb);
+    while (!BaseLessThan(r, b)) {
+        AddWord(q, 1);
+        Sub(r, b);
+    }
+}
+
+void SquareRoot(ANumber& s, ANumber& N)
+{
+    const std::size_t n = N.size();
+
+    if (n < NewtonSqrtThreshold) {
+        ANumber root(0);
+        BaseSqrt(root, N);
+        Assign(s, root);
+        Trim(s);
+        return;
+    }
+
+    // The square root of the leading words gives the leading half of the
+    // root. With h < (n-1)/4 it has more than h words, and one Newton
+    // step from below then leaves it at most a unit too large.
+    const std::size_t h = (n - 2) / 4;
+
+    ANumber top(0);
+    Assign(top, N, 2 * h);
+    SquareRoot(s, top);
+    ShiftUp(s, h);
+
+    ANumber q(0), r(0);
+    DivideWithRemainder(q, r, N, s);
+    Add(s, q);
+    PlatDoubleWord carry;
+    BaseDivideInt(s, 2, WordBase, carry);
+    Trim(s);
+
+    ANumber square(0);
+    Product(square, s, s);
+    while (BaseLessThan(N, square)) {
+        SubWord(s, 1);
+        Product(square, s, s);
+    }
+}
+
+}
+
+void BaseDivideFull(ANumber& aQuotient, ANumber& aRemainder, ANumber& a1, ANumber& a2)
+{
+    const std::size_t n = a2.size();
+    const std::size_t m = a1.size() - n;
+
+    if (n < NewtonDivideThreshold || m + 1 < NewtonDivideThreshold) {
+        WordBaseDivide(aQuotient, aRemainder, a1, a2);
+        return;
+    }
+
+    ANumber a(0), q(0), r(0);
+    Assign(a, a1);
+    Trim(a);
+    DivideWithRemainder(q, r, a, a2);
+
+    // Same layout as the result of long division
+    aQuotient.assign(q.begin(), q.end());
+    aQuotient.resize(m + 1, 0);
+    aRemainder.CopyFrom(a1);
+    aRemainder.assign(r.begin(), r.end());
+    aRemainder.resize(n, 0);
+}
+
+void BaseSqrtFull(ANumber& aResult, const ANumber& N)
+{
+    ANumber n(0), s(0);
+    Assign(n, N);
+    Trim(n);
+    SquareRoot(s, n);
+
+    ANumber root(aResult.Precision());
+    root.assign(s.begin(), s.end());
+    aResult.CopyFrom(root);
+}
@@ -0,0 +1,646 @@
+/* Multiplication of the mantissas of arbitrary precision numbers.
+ *
+ * Small operands are multiplied with the schoolbook method. Larger ones
+ * are split recursively, either in two halves (Karatsuba, three half size
+ * products) or in three thirds (Toom-Cook, five third size products).
+ * Very large operands are multiplied with number theoretic transforms.
+ * Squares have their own code path: the schoolbook square computes every
+ * cross product only once, and the splitting methods recurse into squares
+ * again.
+ *
+ * All routines work on plain arrays of words, least significant word
+ * first, and always produce the exact product, so the result does not
+ * depend on the method that was used.
+ */
+
+#include "yacas/anumber.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+// Set from one environment while those in other threads multiply; each
+// is read on its own, so a change can take effect one threshold at a time
+std::atomic<int> karatsubaThreshold(32);
+std::atomic<int> toom3Threshold(128);
+std::atomic<int> nttThreshold(65536);
+
+typedef std::vector<PlatWord> Words;
+
+void Mul(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny);
+
+std::size_t Trimmed(const PlatWord* a, std::size_t n)
+{
+    while (n && a[n - 1] == 0)
+        n--;
+    return n;
+}
+
+void Trim(Words& a)
+{
+    a.resize(Trimmed(a.data(), a.size()));
+}
+
+// r[0..n) += a[0..na), na <= n. Returns the carry out of the top word.
+PlatWord AddTo(PlatWord* r, std::size_t n, const PlatWord* a, std::size_t na)
+{
+    assert(na <= n);
+
+    PlatDoubleWord carry = 0;
+    std::size_t i = 0;
+    for (; i < na; ++i) {
+        const PlatDoubleWord word =
+            static_cast<PlatDoubleWord>(r[i]) + a[i] + carry;
+        r[i] = static_cast<PlatWord>(word);
+        carry = word >> WordBits;
+    }
+    for (; carry && i < n; ++i) {
+        const PlatDoubleWord word = static_cast<PlatDoubleWord>(r[i]) + carry;
+        r[i] = static_cast<PlatWord>(word);
+        carry = word >> WordBits;
+    }
+    return static_cast<PlatWord>(carry);
+}
+
+// r[0..n) -= a[0..na), na <= n. Returns the borrow out of the top word.
+PlatWord SubFrom(PlatWord* r, std::size_t n, const PlatWord* a, std::size_t na)
+{
+    assert(na <= n);
+
+    PlatWord borrow = 0;
+    std::size_t i = 0;
+    for (; i < na; ++i) {
+        const PlatWord sub = a[i] + borrow;
+        const PlatWord word = r[i] - sub;
+        borrow = (sub < borrow || word > r[i]) ? 1 : 0;
+        r[i] = word;
+    }
+    for (; borrow && i < n; ++i) {
+        borrow = r[i] == 0 ? 1 : 0;
+        r[i]--;
+    }
+    return borrow;
+}
+
+int Compare(const PlatWord* a, std::size_t na, const PlatWord* b, std::size_t nb)
+{
+    na = Trimmed(a, na);
+    nb = Trimmed(b, nb);
+
+    if (na != nb)
+        return na < nb ? -1 : 1;
+
+    while (na--)
+        if (a[na] != b[na])
+            return a[na] < b[na] ? -1 : 1;
+
+    return 0;
+}
+
+// r = |a-b|, with as many words as the longer operand. Returns true if a < b.
+bool AbsDiff(Words& r, const PlatWord* a, std::size_t na, const PlatWord* b, std::size_t nb)
+{
+    const bool swapped = Compare(a, na, b, nb) < 0;
+    if (swapped) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+
+    r.assign(std::max(na, nb), 0);
+    std::copy(a, a + na, r.begin());
+    SubFrom(r.data(), r.size(), b, Trimmed(b, nb));
+
+    return swapped;
+}
+
+void MulBasecase(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny)
+{
+    std::fill(r, r + nx + ny, 0);
+
+    for (std::size_t ix = 0; ix < nx; ++ix) {
+        PlatDoubleWord carry = 0;
+        for (std::size_t iy = 0; iy < ny; ++iy) {
+            const PlatDoubleWord word =
+                static_cast<PlatDoubleWord>(r[ix + iy]) +
+                static_cast<PlatDoubleWord>(x[ix]) * y[iy] + carry;
+            r[ix + iy] = static_cast<PlatWord>(word);
+            carry = word >> WordBits;
+        }
+        r[ix + ny] = static_cast<PlatWord>(carry);
+    }
+}
+
+void SqrBasecase(PlatWord* r, const PlatWord* x, std::size_t n)
+{
+    std::fill(r, r + 2 * n, 0);
+
+    // The products x[i]*x[j] with i < j
+    for (std::size_t i = 0; i < n; ++i) {
+        PlatDoubleWord carry = 0;
+        for (std::size_t j = i + 1; j < n; ++j) {
+            const PlatDoubleWord word =
+                static_cast<PlatDoubleWord>(r[i + j]) +
+                static_cast<PlatDoubleWord>(x[i]) * x[j] + carry;
+            r[i + j] = static_cast<PlatWord>(word);
+            carry = word >> WordBits;
+        }
+        r[i + n] = static_cast<PlatWord>(carry);
+    }
+
+    // ... appear twice in the square
+    PlatWord high = 0;
+    for (std::size_t i = 0; i < 2 * n; ++i) {
+        const PlatWord word = r[i];
+        r[i] = static_cast<PlatWord>(word << 1) | high;
+        high = word >> (WordBits - 1);
+    }
+
+    // and the diagonal x[i]*x[i] once
+    PlatDoubleWord carry = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const PlatDoubleWord sq = static_cast<PlatDoubleWord>(x[i]) * x[i];
+
+        PlatDoubleWord word =
+            static_cast<PlatDoubleWord>(r[2 * i]) + static_cast<PlatWord>(sq) + carry;
+        r[2 * i] = static_cast<PlatWord>(word);
+        carry = word >> WordBits;
+
+        word = static_cast<PlatDoubleWord>(r[2 * i + 1]) + (sq >> WordBits) + carry;
+        r[2 * i + 1] = static_cast<PlatWord>(word);
+        carry = word >> WordBits;
+    }
+    assert(carry == 0);
+}
+
+// x is much longer than y: multiply y by slices of x of the length of y.
+void MulUnbalanced(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny)
+{
+    const std::size_t n = nx + ny;
+    std::fill(r, r + n, 0);
+
+    Words t(2 * ny);
+    for (std::size_t i = 0; i < nx; i += ny) {
+        const std::size_t len = std::min(ny, nx - i);
+        Mul(t.data(), x + i, len, y, ny);
+        const PlatWord carry = AddTo(r + i, n - i, t.data(), len + ny);
+        assert(carry == 0);
+        (void)carry;
+    }
+}
+
+// x*y = z0 + (z0 + z2 - (x0-x1)*(y0-y1))*B^m + z2*B^2m
+void MulKaratsuba(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny, bool square)
+{
+    const std::size_t n = nx + ny;
+    const std::size_t m = (nx + 1) / 2;
+    assert(ny > m);
+
+    const PlatWord* x1 = x + m;
+    const PlatWord* y1 = y + m;
+    const std::size_t nx1 = nx - m;
+    const std::size_t ny1 = ny - m;
+
+    Mul(r, x, m, y, m);
+    Mul(r + 2 * m, x1, nx1, y1, ny1);
+
+    Words dx, dy, d(2 * m);
+    bool negative = AbsDiff(dx, x, m, x1, nx1);
+    if (square) {
+        Mul(d.data(), dx.data(), m, dx.data(), m);
+        negative = false;
+    } else {
+        negative = AbsDiff(dy, y, m, y1, ny1) != negative;
+        Mul(d.data(), dx.data(), m, dy.data(), m);
+    }
+
+    Words mid(2 * m + 1, 0);
+    std::copy(r, r + 2 * m, mid.begin());
+    AddTo(mid.data(), mid.size(), r + 2 * m, nx1 + ny1);
+    if (negative)
+        AddTo(mid.data(), mid.size(), d.data(), d.size());
+    else
+        SubFrom(mid.data(), mid.size(), d.data(), d.size());
+
+    Trim(mid);
+    const PlatWord carry = AddTo(r + m, n - m, mid.data(), mid.size());
+    assert(carry == 0);
+    (void)carry;
+}
+
+// Signed numbers for the Toom-Cook interpolation, with the magnitude
+// kept without leading zero words.
+struct Signed {
+    Words w;
+    bool negative;
+};
+
+Signed MakeSigned(const PlatWord* a, std::size_t n)
+{
+    Signed s;
+    s.w.assign(a, a + Trimmed(a, n));
+    s.negative = false;
+    return s;
+}
+
+Signed Add(const Signed& a, const Signed& b, bool aNegateB = false)
+{
+    const bool bNegative = b.negative != aNegateB;
+
+    Signed r;
+    if (a.negative == bNegative) {
+        r.w.assign(std::max(a.w.size(), b.w.size()) + 1, 0);
+        std::copy(a.w.begin(), a.w.end(), r.w.begin());
+        AddTo(r.w.data(), r.w.size(), b.w.data(), b.w.size());
+        r.negative = a.negative;
+    } else {
+        r.negative = AbsDiff(r.w, a.w.data(), a.w.size(), b.w.data(), b.w.size()) ? bNegative : a.negative;
+    }
+    Trim(r.w);
+    if (r.w.empty())
+        r.negative = false;
+    return r;
+}
+
+Signed Sub(const Signed& a, const Signed& b)
+{
+    return Add(a, b, true);
+}
+
+Signed Twice(const Signed& a)
+{
+    return Add(a, a);
+}
+
+void DivideExactly(Signed& a, PlatWord aDivisor)
+{
+    PlatDoubleWord rem = 0;
+    for (std::size_t i = a.w.size(); i--; ) {
+        const PlatDoubleWord word = (rem << WordBits) + a.w[i];
+        a.w[i] = static_cast<PlatWord>(word / aDivisor);
+        rem = word % aDivisor;
+    }
+    assert(rem == 0);
+    Trim(a.w);
+}
+
+Signed Product(const Signed& a, const Signed& b)
+{
+    Signed r;
+    r.negative = false;
+    if (a.w.empty() || b.w.empty())
+        return r;
+
+    r.w.resize(a.w.size() + b.w.size());
+    if (&a == &b)
+        Mul(r.w.data(), a.w.data(), a.w.size(), a.w.data(), a.w.size());
+    else
+        Mul(r.w.data(), a.w.data(), a.w.size(), b.w.data(), b.w.size());
+    Trim(r.w);
+    r.negative = a.negative != b.negative;
+    return r;
+}
+
+void AddShifted(PlatWord* r, std::size_t n, std::size_t aShift, const Signed& a)
+{
+    assert(!a.negative);
+    const PlatWord carry = AddTo(r + aShift, n - aShift, a.w.data(), a.w.size());
+    assert(carry == 0);
+    (void)carry;
+}
+
+// Toom-Cook 3-way multiplication, evaluating in 0, 1, -1, -2 and infinity,
+// with the interpolation sequence due to Bodrato.
+void MulToom3(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny, bool square)
+{
+    const std::size_t n = nx + ny;
+    const std::size_t k = (nx + 2) / 3;
+    assert(ny > 2 * k);
+
+    const Signed x0 = MakeSigned(x, k);
+    const Signed x1 = MakeSigned(x + k, k);
+    const Signed x2 = MakeSigned(x + 2 * k, nx - 2 * k);
+
+    Signed xp = Add(x0, x2);
+    const Signed x_1 = Add(xp, x1);
+    const Signed x_m1 = Sub(xp, x1);
+    const Signed x_m2 = Sub(Twice(Add(x_m1, x2)), x0);
+
+    Signed r0, r1, rm1, rm2, rinf;
+    if (square) {
+        r0 = Product(x0, x0);
+        r1 = Product(x_1, x_1);
+        rm1 = Product(x_m1, x_m1);
+        rm2 = Product(x_m2, x_m2);
+        rinf = Product(x2, x2);
+    } else {
+        const Signed y0 = MakeSigned(y, k);
+        const Signed y1 = MakeSigned(y + k, k);
+        const Signed y2 = MakeSigned(y + 2 * k, ny - 2 * k);
+
+        const Signed yp = Add(y0, y2);
+        const Signed y_1 = Add(yp, y1);
+        const Signed y_m1 = Sub(yp, y1);
+        const Signed y_m2 = Sub(Twice(Add(y_m1, y2)), y0);
+
+        r0 = Product(x0, y0);
+        r1 = Product(x_1, y_1);
+        rm1 = Product(x_m1, y_m1);
+        rm2 = Product(x_m2, y_m2);
+        rinf = Product(x2, y2);
+    }
+
+    Signed r3 = Sub(rm2, r1);
+    DivideExactly(r3, 3);
+    r1 = Sub(r1, rm1);
+    DivideExactly(r1, 2);
+    Signed r2 = Sub(rm1, r0);
+    r3 = Sub(r2, r3);
+    DivideExactly(r3, 2);
+    r3 = Add(r3, Twice(rinf));
+    r2 = Sub(Add(r2, r1), rinf);
+    r1 = Sub(r1, r3);
+
+    std::fill(r, r + n, 0);
+    std::copy(r0.w.begin(), r0.w.end(), r);
+    std::copy(rinf.w.begin(), rinf.w.end(), r + 4 * k);
+    AddShifted(r, n, k, r1);
+    AddShifted(r, n, 2 * k, r2);
+    AddShifted(r, n, 3 * k, r3);
+}
+
+// Number theoretic transform multiplication. The operands are cut into
+// pieces of at most 32 bits, their convolution is computed modulo three
+// primes of the form k*2^m+1 below 2^30, and the exact convolution is
+// recovered with the Chinese remainder theorem. With at most 2^21 pieces
+// per operand the convolution stays below 2^85, which is less than the
+// product of the primes. Only integer arithmetic is used, so the result is
+// exact.
+typedef std::uint32_t ModWord;
+typedef std::uint64_t ModDoubleWord;
+
+const ModWord NttPrimes[3] = { 998244353, 167772161, 469762049 };
+const ModWord NttGenerator = 3;
+const std::size_t NttMaxLength = std::size_t(1) << 22;
+const unsigned NttPieceBits = WordBits < 32 ? WordBits : 32;
+const unsigned NttPiecesPerWord = WordBits / NttPieceBits;
+const ModDoubleWord NttPieceMask = (ModDoubleWord(1) << NttPieceBits) - 1;
+
+ModWord PowMod(ModWord aBase, ModWord aExp, ModWord aMod)
+{
+    ModDoubleWord result = 1, base = aBase;
+    while (aExp) {
+        if (aExp & 1)
+            result = result * base % aMod;
+        base = base * base % aMod;
+        aExp >>= 1;
+    }
+    return static_cast<ModWord>(result);
+}
+
+// Montgomery arithmetic modulo p with R = 2^32, which avoids divisions in
+// the transforms. Mul(a, b*R mod p) is a*b mod p, so the twiddle factors are
+// kept multiplied by R and the data itself in the ordinary representation.
+struct Montgomery {
+    explicit Montgomery(ModWord aPrime):
+        p(aPrime), pinv(1), r2(static_cast<ModWord>((ModDoubleWord(1) << 63) % aPrime * 2 % aPrime))
+    {
+        // Newton iteration for -1/p modulo 2^32
+        for (int i = 0; i < 5; ++i)
+            pinv *= 2 - p * pinv;
+        pinv = -pinv;
+    }
+
+    // a*b/R mod p
+    ModWord Mul(ModWord a, ModWord b) const
+    {
+        const ModDoubleWord t = ModDoubleWord(a) * b;
+        const ModWord m = static_cast<ModWord>(t) * pinv;
+        const ModWord u = static_cast<ModWord>((t + ModDoubleWord(m) * p) >> 32);
+        return u >= p ? u - p : u;
+    }
+
+    // a*R mod p
+    ModWord ToMontgomery(ModWord a) const
+    {
+        return Mul(a, r2);
+    }
+
+    ModWord p;
+    ModWord pinv;
+    ModWord r2;
+};
+
+void Ntt(std::vector<ModWord>& a, bool aInverse, const Montgomery& aMont)
+{
+    const ModWord p = aMont.p;
+    const std::size_t n = a.size();
+
+    for (std::size_t i = 1, j = 0; i < n; ++i) {
+        std::size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    std::vector<ModWord> roots(n / 2);
+    for (std::size_t len = 2; len <= n; len <<= 1) {
+        const std::size_t half = len / 2;
+
+        ModWord w = PowMod(NttGenerator, (p - 1) / len, p);
+        if (aInverse)
+            w = PowMod(w, p - 2, p);
+        w = aMont.ToMontgomery(w);
+
+        roots[0] = aMont.ToMontgomery(1);
+        for (std::size_t j = 1; j < half; ++j)
+            roots[j] = aMont.Mul(roots[j - 1], w);
+
+        for (std::size_t i = 0; i < n; i += len) {
+            ModWord* lo = &a[i];
+            ModWord* hi = &a[i + half];
+            for (std::size_t j = 0; j < half; ++j) {
+                const ModWord u = lo[j];
+                const ModWord v = aMont.Mul(hi[j], roots[j]);
+                lo[j] = u + v < p ? u + v : u + v - p;
+                hi[j] = u >= v ? u - v : u + p - v;
+            }
+        }
+    }
+}
+
+void ToPieces(std::vector<ModWord>& aPieces, ModWord aPrime, const PlatWord* x, std::size_t nx, std::size_t aLength)
+{
+    aPieces.assign(aLength, 0);
+    for (std::size_t i = 0; i < nx; ++i) {
+        PlatWord word = x[i];
+        for (unsigned j = 0; j < NttPiecesPerWord; ++j) {
+            const ModDoubleWord piece = ModDoubleWord(word) & NttPieceMask;
+            aPieces[i * NttPiecesPerWord + j] = static_cast<ModWord>(piece % aPrime);
+            word = static_cast<PlatWord>(PlatDoubleWord(word) >> NttPieceBits);
+        }
+    }
+}
+
+// aResult = the convolution of the pieces of x and y, modulo aPrime
+void NttConvolve(std::vector<ModWord>& aResult, ModWord aPrime,
+                 const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny,
+                 std::size_t aLength, bool aSquare)
+{
+    const Montgomery mont(aPrime);
+
+    ToPieces(aResult, aPrime, x, nx, aLength);
+    Ntt(aResult, false, mont);
+    if (aSquare) {
+        for (ModWord& c: aResult)
+            c = mont.Mul(c, c);
+    } else {
+        std::vector<ModWord> fy;
+        ToPieces(fy, aPrime, y, ny, aLength);
+        Ntt(fy, false, mont);
+        for (std::size_t i = 0; i < aLength; ++i)
+            aResult[i] = mont.Mul(aResult[i], fy[i]);
+    }
+    Ntt(aResult, true, mont);
+
+    // The pointwise products were divided by R, and the inverse transform
+    // still has to be divided by its length.
+    const ModWord scale = mont.ToMontgomery(mont.ToMontgomery(PowMod(aLength % aPrime, aPrime - 2, aPrime)));
+    for (ModWord& c: aResult)
+        c = mont.Mul(c, scale);
+}
+
+// (aHigh:aLow) += a*b
+void MulAdd128(ModDoubleWord& aLow, ModDoubleWord& aHigh, ModDoubleWord a, ModDoubleWord b)
+{
+    const ModDoubleWord mask = 0xffffffff;
+    const ModDoubleWord ll = (a & mask) * (b & mask);
+    const ModDoubleWord lh = (a & mask) * (b >> 32);
+    const ModDoubleWord hl = (a >> 32) * (b & mask);
+    const ModDoubleWord hh = (a >> 32) * (b >> 32);
+
+    const ModDoubleWord mid = (ll >> 32) + (lh & mask) + (hl & mask);
+    const ModDoubleWord low = (mid << 32) | (ll & mask);
+    const ModDoubleWord high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    aHigh += high + (aLow + low < aLow ? 1 : 0);
+    aLow += low;
+}
+
+bool NttFits(std::size_t nx, std::size_t ny)
+{
+    return (nx + ny) * NttPiecesPerWord <= NttMaxLength;
+}
+
+void MulNtt(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny, bool square)
+{
+    const std::size_t n = nx + ny;
+
+    std::size_t length = 1;
+    while (length < n * NttPiecesPerWord)
+        length <<= 1;
+
+    std::vector<ModWord> residues[3];
+    for (int k = 0; k < 3; ++k)
+        NttConvolve(residues[k], NttPrimes[k], x, nx, y, ny, length, square);
+
+    // Garner's algorithm: c = r0 + p0*(t1 + p1*t2)
+    const ModDoubleWord p0 = NttPrimes[0], p1 = NttPrimes[1], p2 = NttPrimes[2];
+    const ModDoubleWord inv_p0_p1 = PowMod(p0 % p1, p1 - 2, p1);
+    const ModDoubleWord inv_p0p1_p2 = PowMod(p0 % p2 * (p1 % p2) % p2, p2 - 2, p2);
+    const ModDoubleWord p0p1 = p0 * p1;
+
+    ModDoubleWord low = 0, high = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        PlatWord word = 0;
+        for (unsigned j = 0; j < NttPiecesPerWord; ++j) {
+            const std::size_t k = i * NttPiecesPerWord + j;
+            const ModDoubleWord r0 = residues[0][k];
+            const ModDoubleWord t1 = (residues[1][k] + p1 - r0 % p1) % p1 * inv_p0_p1 % p1;
+            const ModDoubleWord c01 = r0 + p0 * t1;
+            const ModDoubleWord t2 = (residues[2][k] + p2 - c01 % p2) % p2 * inv_p0p1_p2 % p2;
+
+            high += (low + c01 < low) ? 1 : 0;
+            low += c01;
+            MulAdd128(low, high, p0p1, t2);
+
+            word |= static_cast<PlatWord>(PlatDoubleWord(low & NttPieceMask) << (j * NttPieceBits));
+            low = (low >> NttPieceBits) | (high << (64 - NttPieceBits));
+            high >>= NttPieceBits;
+        }
+        r[i] = word;
+    }
+    assert(low == 0 && high == 0);
+}
+
+// r[0..nx+ny) = x*y. Passing the same array for x and y selects squaring.
+void Mul(PlatWord* r, const PlatWord* x, std::size_t nx, const PlatWord* y, std::size_t ny)
+{
+    const std::size_t n = nx + ny;
+    const bool square = x == y && nx == ny;
+
+    nx = Trimmed(x, nx);
+    ny = Trimmed(y, ny);
+    if (nx == 0 || ny == 0) {
+        std::fill(r, r + n, 0);
+        return;
+    }
+    std::fill(r + nx + ny, r + n, 0);
+
+    if (nx < ny) {
+        std::swap(x, y);
+        std::swap(nx, ny);
+    }
+
+    if (ny < std::size_t(karatsubaThreshold.load(std::memory_order_relaxed))) {
+        if (square)
+            SqrBasecase(r, x, nx);
+        else
+            MulBasecase(r, x, nx, y, ny);
+    } else if (ny >= std::size_t(nttThreshold.load(std::memory_order_relaxed)) && NttFits(nx, ny)) {
+        MulNtt(r, x, nx, y, ny, square);
+    } else if (ny <= (nx + 1) / 2) {
+        MulUnbalanced(r, x, nx, y, ny);
+    } else if (ny >= std::size_t(toom3Threshold.load(std::memory_order_relaxed)) && ny > 2 * ((nx + 2) / 3)) {
+        MulToom3(r, x, nx, y, ny, square);
+    } else {
+        MulKaratsuba(r, x, nx, y, ny, square);
+    }
+}
+
+}
+
+MultiplyThresholds GetMultiplyThresholds()
+{
+    MultiplyThresholds thresholds;
+    thresholds.karatsuba = karatsubaThreshold;
+    thresholds.toom3 = toom3Threshold;
+    thresholds.ntt = nttThreshold;
+    return thresholds;
+}
+
+void SetMultiplyThresholds(const MultiplyThresholds& aThresholds)
+{
+    // The splitting methods need pieces of at least two words
+    karatsubaThreshold = std::max(aThresholds.karatsuba, 4);
+    toom3Threshold = std::max(aThresholds.toom3, 6);
+    nttThreshold = std::max(aThresholds.ntt, 1);
+}
+
+void BaseMultiplyFull(ANumber& aResult, ANumber& a1, ANumber& a2)
+{
+    const std::size_t n1 = a1.size();
+    const std::size_t n2 = a2.size();
+
+    const bool square =
+        &a1 == &a2 || (n1 == n2 && std::equal(a1.begin(), a1.end(), a2.begin()));
+
+    aResult.resize(n1 + n2 + 1);
+    Mul(aResult.data(), a1.data(), n1, square ? a1.data() : a2.data(), n2);
+    aResult[n1 + n2] = 0;
+}
@@ -0,0 +1,208 @@
+/* Conversion of the integer part of the mantissas of arbitrary precision
+ * numbers to and from strings of digits in a given base.
+ *
+ * Small numbers are converted a word at a time. Larger numbers are split
+ * at a power of the base into two halves which are converted recursively:
+ * the digits "hi lo" stand for hi*B^k+lo, so reading takes a
+ * multiplication and writing a division per split, and both directions
+ * profit from the fast multiplication and division routines. The powers
+ * used for splitting are cached per base.
+ *
+ * Digits are passed as their values 0..aBase-1, most significant first.
+ */
+
+#include "yacas/anumber.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+void BaseMultiplyFull(ANumber& aResult, ANumber& a1, ANumber& a2);
+
+namespace {
+
+// Numbers of at most this many words are converted word by word
+const std::size_t RadixThreshold = 30;
+
+// powers[i] = chunk^(2^i), where chunk is the largest power of the base
+// that fits in a word, and chunkDigits its number of digits.
+struct PowerTable {
+    int chunkDigits;
+    PlatWord chunk;
+    std::vector<std::shared_ptr<ANumber>> powers;
+};
+
+// The tables outlive the environments, so the powers are allocated from
+// the shared arena. Environments in other threads use them too: they are
+// grown under the lock, and a power is handed out as a shared pointer
+// rather than a reference into a vector another thread may reallocate.
+std::mutex powerTablesMutex;
+std::map<int, PowerTable> powerTables;
+
+void Trim(ANumber& a)
+{
+    std::size_t n = a.size();
+    while (n && a[n - 1] == 0)
+        n--;
+    a.resize(n);
+}
+
+PowerTable& Powers(int aBase)
+{
+    std::lock_guard<std::mutex> lock(powerTablesMutex);
+    Arena::Scope scope(nullptr);
+
+    PowerTable& table = powerTables[aBase];
+
+    if (table.powers.empty()) {
+        PlatDoubleWord chunk = aBase;
+        table.chunkDigits = 1;
+        while (chunk * aBase < WordBase) {
+            chunk *= aBase;
+            table.chunkDigits++;
+        }
+        table.chunk = static_cast<PlatWord>(chunk);
+
+        std::shared_ptr<ANumber> power = std::make_shared<ANumber>(0);
+        (*power)[0] = table.chunk;
+        table.powers.push_back(power);
+    }
+
+    return table;
+}
+
+std::shared_ptr<ANumber> Power(PowerTable& aTable, std::size_t i)
+{
+    std::lock_guard<std::mutex> lock(powerTablesMutex);
+    Arena::Scope scope(nullptr);
+
+    while (aTable.powers.size() <= i) {
+        ANumber& last = *aTable.powers.back();
+        std::shared_ptr<ANumber> square = std::make_shared<ANumber>(0);
+        BaseMultiplyFull(*square, last, last);
+        Trim(*square);
+        aTable.powers.push_back(square);
+    }
+
+    return aTable.powers[i];
+}
+
+// Append the digits of x to aDigits, padded with zeros to aPad digits,
+// or without leading zeros if aPad is 0. x is destroyed.
+void ToDigits(std::string& aDigits, ANumber& x, std::size_t aPad, PowerTable& aTable, int aBase)
+{
+    Trim(x);
+
+    if (x.size() <= RadixThreshold) {
+        // Peel off chunks of digits, least significant first
+        std::string digits;
+        while (!x.empty()) {
+            PlatDoubleWord rem;
+            BaseDivideInt(x, aTable.chunk, WordBase, rem);
+            Trim(x);
+            for (int k = 0; k < aTable.chunkDigits; ++k) {
+                digits.push_back(static_cast<char>(rem % aBase));
+                rem /= aBase;
+            }
+        }
+
+        while (!digits.empty() && digits.back() == 0)
+            digits.pop_back();
+
+        assert(aPad == 0 || digits.size() <= aPad);
+        if (digits.size() < aPad)
+            digits.resize(aPad, 0);
+
+        aDigits.append(digits.rbegin(), digits.rend());
+        return;
+    }
+
+    // Split at the largest cached power with at most half the words of x
+    std::size_t i = 0;
+    while (2 * Power(aTable, i + 1)->size() <= x.size())
+        i++;
+
+    const std::size_t lowDigits = std::size_t(aTable.chunkDigits) << i;
+
+    ANumber divisor(*Power(aTable, i));
+    ANumber high(0), low(0);
+    IntegerDivide(high, low, x, divisor);
+
+    ToDigits(aDigits, high, aPad ? aPad - lowDigits : 0, aTable, aBase);
+    ToDigits(aDigits, low, lowDigits, aTable, aBase);
+}
+
+void FromDigits(ANumber& aResult, const char* aDigits, std::size_t aSize, PowerTable& aTable, int aBase)
+{
+    const std::size_t chunkDigits = aTable.chunkDigits;
+
+    if (aSize <= RadixThreshold * chunkDigits) {
+        aResult.assign(1, 0);
+
+        std::size_t len = aSize % chunkDigits;
+        if (len == 0)
+            len = chunkDigits;
+
+        for (std::size_t pos = 0; pos < aSize; pos += len, len = chunkDigits) {
+            PlatDoubleWord factor = 1;
+            PlatDoubleWord value = 0;
+            for (std::size_t k = 0; k < len; ++k) {
+                value = value * aBase + aDigits[pos + k];
+                factor *= aBase;
+            }
+
+            WordBaseTimesInt(aResult, factor);
+            for (std::size_t k = 0; value; ++k) {
+                if (k == aResult.size())
+                    aResult.push_back(0);
+                value += aResult[k];
+                aResult[k] = static_cast<PlatWord>(value);
+                value >>= WordBits;
+            }
+        }
+        return;
+    }
+
+    // Split off the lowest chunkDigits*2^i digits, the most that leaves
+    // at least one digit in the high part
+    std::size_t i = 0;
+    while ((chunkDigits << (i + 1)) < aSize)
+        i++;
+
+    const std::size_t lowDigits = chunkDigits << i;
+
+    ANumber high(0), low(0);
+    FromDigits(high, aDigits, aSize - lowDigits, aTable, aBase);
+    FromDigits(low, aDigits + aSize - lowDigits, lowDigits, aTable, aBase);
+
+    Trim(high);
+    if (high.empty()) {
+        aResult.assign(low.begin(), low.end());
+        return;
+    }
+
+    BaseMultiplyFull(aResult, high, *Power(aTable, i));
+    WordBaseAdd(aResult, low);
+}
+
+}
+
+void BaseToDigits(std::string& aDigits, const PlatWord* aWords, std::size_t aSize, int aBase)
+{
+    ANumber x(0);
+    x.assign(aWords, aWords + aSize);
+
+    aDigits.clear();
+    ToDigits(aDigits, x, 0, Powers(aBase), aBase);
+
+    if (aDigits.empty())
+        aDigits.push_back(0);
+}
+
+void BaseFromDigits(ANumber& aResult, const std::string& aDigits, int aBase)
+{
+    FromDigits(aResult, aDigits.data(), aDigits.size(), Powers(aBase), aBase);
+}
@@ -0,0 +1,234 @@
+#include "yacas/arena.h"
+#include "yacas/stubs.h"
+
+#include <cassert>
+#include <cstdint>
+
+// The headers are aligned so that the blocks after them are too
+struct alignas(16) Arena::Chunk {
+    Arena* owner;
+};
+
+struct alignas(16) Arena::Large {
+    Arena* owner;
+    Large* prev;
+    Large* next;
+    std::size_t size;
+};
+
+struct Arena::Region {
+    Region* next;
+    void* memory;
+};
+
+thread_local Arena* Arena::current = nullptr;
+
+Arena::Arena():
+    Arena(false)
+{
+}
+
+Arena::Arena(bool aShared):
+    iClasses(),
+    iRegions(nullptr),
+    iFreeChunks(0),
+    iLarge(nullptr),
+    iNrLarge(0),
+    iLargeBytes(0),
+    iNrChunks(0),
+    iAllocations(0),
+    iShared(aShared)
+{
+}
+
+Arena::~Arena()
+{
+    assert(current != this);
+
+    while (iLarge) {
+        Large* next = iLarge->next;
+        PlatFree(iLarge);
+        iLarge = next;
+    }
+
+    while (iRegions) {
+        Region* next = iRegions->next;
+        PlatFree(iRegions->memory);
+        delete iRegions;
+        iRegions = next;
+    }
+}
+
+Arena& Arena::Shared()
+{
+    // never destroyed, as objects in it may be released at any time
+    static Arena* shared = new Arena(true);
+    return *shared;
+}
+
+Arena& Arena::Current()
+{
+    return current ? *current : Shared();
+}
+
+void* Arena::Allocate(std::size_t aSize)
+{
+    Arena& arena = Current();
+
+    std::unique_lock<std::mutex> lock(arena.iMutex, std::defer_lock);
+    if (arena.iShared)
+        lock.lock();
+
+    arena.iAllocations += 1;
+
+    if (aSize > MaxSmall)
+        return arena.AllocateLarge(aSize);
+
+    return arena.AllocateSmall(aSize ? (aSize - 1) / Granularity : 0);
+}
+
+void Arena::Free(void* aBlock, std::size_t aSize)
+{
+    if (!aBlock)
+        return;
+
+    Arena* owner;
+    if (aSize > MaxSmall)
+        owner = (static_cast<Large*>(aBlock) - 1)->owner;
+    else
+        owner = reinterpret_cast<Chunk*>(reinterpret_cast<std::uintptr_t>(aBlock) & ~(ChunkSize - 1))->owner;
+
+    // Only the shared arena is used by several threads at once, any
+    // other is not locked and must not be changed from another thread
+    // while it is current on its own
+    assert(owner->iShared || owner == current || !current);
+
+    std::unique_lock<std::mutex> lock(owner->iMutex, std::defer_lock);
+    if (owner->iShared)
+        lock.lock();
+
+    if (aSize > MaxSmall)
+        owner->FreeLarge((static_cast<Large*>(aBlock) - 1));
+    else
+        owner->FreeSmall(aBlock, aSize ? (aSize - 1) / Granularity : 0);
+}
+
+void* Arena::AllocateSmall(std::size_t aClass)
+{
+    Class& c = iClasses[aClass];
+    c.blocks += 1;
+
+    if (FreeBlock* block = c.free) {
+        c.free = block->next;
+        return block;
+    }
+
+    const std::size_t size = (aClass + 1) * Granularity;
+
+    if (!c.next || c.next + size > c.end) {
+        char* chunk = reinterpret_cast<char*>(NewChunk());
+        c.next = chunk + sizeof(Chunk);
+        c.end = chunk + ChunkSize;
+    }
+
+    void* block = c.next;
+    c.next += size;
+    return block;
+}
+
+void Arena::FreeSmall(void* aBlock, std::size_t aClass)
+{
+    Class& c = iClasses[aClass];
+    c.blocks -= 1;
+
+    FreeBlock* block = static_cast<FreeBlock*>(aBlock);
+    block->next = c.free;
+    c.free = block;
+}
+
+Arena::Chunk* Arena::NewChunk()
+{
+    if (!iFreeChunks) {
+        // One chunk extra to align the others to their size
+        void* memory = PlatAlloc((ChunksPerRegion + 1) * ChunkSize);
+        Region* region = new Region;
+        region->memory = memory;
+        region->next = iRegions;
+        iRegions = region;
+        iFreeChunks = ChunksPerRegion;
+    }
+
+    const std::uintptr_t base = (reinterpret_cast<std::uintptr_t>(iRegions->memory) + ChunkSize - 1) & ~(ChunkSize - 1);
+    iFreeChunks -= 1;
+    iNrChunks += 1;
+
+    Chunk* chunk = reinterpret_cast<Chunk*>(base + (ChunksPerRegion - 1 - iFreeChunks) * ChunkSize);
+    chunk->owner = this;
+    return chunk;
+}
+
+void* Arena::AllocateLarge(std::size_t aSize)
+{
+    Large* large = static_cast<Large*>(PlatAlloc(sizeof(Large) + aSize));
+    large->owner = this;
+    large->prev = nullptr;
+    large->next = iLarge;
+    large->size = aSize;
+    if (iLarge)
+        iLarge->prev = large;
+    iLarge = large;
+
+    iNrLarge += 1;
+    iLargeBytes += aSize;
+
+    return large + 1;
+}
+
+void Arena::FreeLarge(Large* aLarge)
+{
+    if (aLarge->prev)
+        aLarge->prev->next = aLarge->next;
+    else
+        iLarge = aLarge->next;
+    if (aLarge->next)
+        aLarge->next->prev = aLarge->prev;
+
+    iNrLarge -= 1;
+    iLargeBytes -= aLarge->size;
+
+    PlatFree(aLarge);
+}
+
+Arena::Statistics Arena::GetStatistics()
+{
+    std::unique_lock<std::mutex> lock(iMutex, std::defer_lock);
+    if (iShared)
+        lock.lock();
+
+    Statistics statistics = Statistics();
+
+    for (std::size_t i = 0; i < NrClasses; ++i) {
+        statistics.blocks += iClasses[i].blocks;
+        statistics.bytes += iClasses[i].blocks * (i + 1) * Granularity;
+    }
+
+    statistics.large = iNrLarge;
+    statistics.largeBytes = iLargeBytes;
+    statistics.chunks = iNrChunks;
+    for (Region* region = iRegions; region; region = region->next)
+        statistics.reserved += (ChunksPerRegion + 1) * ChunkSize;
+    statistics.allocations = iAllocations;
+
+    return statistics;
+}
+
+Arena::Scope::Scope(Arena* aArena):
+    iPrevious(current)
+{
+    current = aArena;
+}
+
+Arena::Scope::~Scope()
+{
+    current = iPrevious;
+}
@@ -8,6 +8,8 @@
 #include "yacas/platmath.h"
 #include "yacas/errors.h"
 
+#include <climits>
+
 static
 const LispString* GetIntegerArgument(LispEnvironment& aEnvironment, int aStackTop, int aArgNr)
 {
@@ -19,6 +21,10 @@ const LispString* GetIntegerArgument(LispEnvironment& aEnvironment, int aStackTo
 
 int GetShortIntegerArgument(LispEnvironment& aEnvironment, int aStackTop, int aArgNr)
 {
+  std::int64_t n;
+  if (aEnvironment.iStack[aStackTop + aArgNr]->SmallInteger(n) && n >= INT_MIN && n <= INT_MAX)
+    return static_cast<int>(n);
+
   const LispString* str = GetIntegerArgument(aEnvironment, aStackTop, aArgNr);
   return InternalAsciiToInt(*str);
 }
@@ -19,41 +19,129 @@
 
 #include "yacas/associationclass.h"
 
+#include <iterator>
+
+template <typename F>
+void AssociationClass::ForEach(F f) const
+{
+    if (_backend == Hashed) {
+        for (Entries::const_reference e: _entries)
+            f(e.first.value, e.second);
+    } else {
+        for (std::map<Key, LispPtr>::const_reference e: _map)
+            f(e.first.value, e.second);
+    }
+}
+
+AssociationClass::Entries::iterator AssociationClass::Find(const Key& k)
+{
+    if (!InternalHashIsExact(k.hash)) {
+        for (Entries::iterator e = _entries.begin(); e != _entries.end(); ++e)
+            if (e->first == k)
+                return e;
+        return _entries.end();
+    }
+
+    for (std::size_t h: {k.hash, std::size_t(0)}) {
+        auto range = _index.equal_range(h);
+        for (auto i = range.first; i != range.second; ++i)
+            if (i->second->first == k)
+                return i->second;
+    }
+
+    return _entries.end();
+}
+
+LispObject* AssociationClass::GetElement(LispObject* k)
+{
+    if (_backend == Hashed) {
+        Entries::iterator e = Find(Key(_env, k));
+        if (e != _entries.end())
+            return e->second;
+    } else {
+        auto p = _map.find(Key(_env, k));
+        if (p != _map.end())
+            return p->second;
+    }
+    return nullptr;
+}
+
+void AssociationClass::SetElement(LispObject* k, LispObject* v)
+{
+    const Key key(_env, k);
+
+    if (_backend == Hashed) {
+        Entries::iterator e = Find(key);
+        if (e != _entries.end()) {
+            e->second = v;
+        } else {
+            _entries.push_back(std::make_pair(key, LispPtr(v)));
+            const std::size_t h = InternalHashIsExact(key.hash) ? key.hash : 0;
+            _index.insert(std::make_pair(h, std::prev(_entries.end())));
+        }
+    } else {
+        _map[key] = v;
+    }
+}
+
+bool AssociationClass::DropElement(LispObject* k)
+{
+    if (_backend != Hashed)
+        return _map.erase(Key(_env, k));
+
+    Entries::iterator e = Find(Key(_env, k));
+    if (e == _entries.end())
+        return false;
+
+    const std::size_t h = InternalHashIsExact(e->first.hash) ? e->first.hash : 0;
+    auto range = _index.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+        if (i->second == e) {
+            _index.erase(i);
+            break;
+        }
+    }
+    _entries.erase(e);
+    return true;
+}
+
 LispPtr AssociationClass::Keys() const
 {
     LispPtr head(LispAtom::New(const_cast<LispEnvironment&>(_env), "List"));
     LispPtr p(head);
-    for (std::map<Key, LispPtr>::const_reference e: _map) {
-        p->Nixed() = e.first.value->Copy();
+    ForEach([&p](const LispPtr& key, const LispPtr&) {
+        p->Nixed() = key->Copy();
         p = p->Nixed();
-    }
+    });
     return LispPtr(LispSubList::New(head));
 }
 
 LispPtr AssociationClass::ToList() const
 {
-    LispPtr head(LispAtom::New(const_cast<LispEnvironment&>(_env), "List"));
+    LispEnvironment& env = const_cast<LispEnvironment&>(_env);
+    LispPtr head(LispAtom::New(env, "List"));
     LispPtr p(head);
-    for (std::map<Key, LispPtr>::const_reference e: _map) {
-        LispPtr q(LispAtom::New(const_cast<LispEnvironment&>(_env), "List"));
+    ForEach([&p, &env](const LispPtr& key, const LispPtr& value) {
+        LispPtr q(LispAtom::New(env, "List"));
         p->Nixed() = LispSubList::New(q);
         p = p->Nixed();
-        q->Nixed() = e.first.value->Copy();
+        q->Nixed() = key->Copy();
         q = q->Nixed();
-        q->Nixed() = e.second->Copy();
-    }
+        q->Nixed() = value->Copy();
+    });
     return LispPtr(LispSubList::New(head));
 }
 
 LispPtr AssociationClass::Head() const
 {
-    assert(_map.size());
+    assert(Size());
     
-    std::map<Key, LispPtr>::const_reference e = *_map.begin();
+    const LispPtr& key = _backend == Hashed ? _entries.front().first.value : _map.begin()->first.value;
+    const LispPtr& value = _backend == Hashed ? _entries.front().second : _map.begin()->second;
     LispPtr p(LispAtom::New(const_cast<LispEnvironment&>(_env), "List"));
     LispPtr q(p);
-    q->Nixed() = e.first.value->Copy();
+    q->Nixed() = key->Copy();
     q = q->Nixed();
-    q->Nixed() = e.second->Copy();
+    q->Nixed() = value->Copy();
     return LispPtr(LispSubList::New(p));
 }
@@ -9,6 +9,8 @@
 #include "yacas/tokenizer.h"
 #include "yacas/stringio.h"
 
+#include <algorithm>
+
 LispDefFile::LispDefFile(const std::string& aFileName):
     iFileName(aFileName),
     iIsLoaded(false)
@@ -73,6 +75,9 @@ static void DoLoadDefFile(
         aEnvironment.Protect(token);
     }
   }
+
+  // calls of the symbols defined in the file must load it first
+  aEnvironment.InvalidateDispatchCache();
 }
 
 void LoadDefFile(LispEnvironment& aEnvironment, const std::string& aFileName)
@@ -88,6 +93,10 @@ void LoadDefFile(LispEnvironment& aEnvironment, const std::string& aFileName)
   if (!localFP.stream.is_open())
     throw LispErrFileNotFound();
 
+  std::vector<std::string>& loaded = aEnvironment.iLoadedFiles;
+  if (std::find(loaded.begin(), loaded.end(), flatfile) == loaded.end())
+    loaded.push_back(flatfile);
+
   StdFileInput newInput(localFP,aEnvironment.iInputStatus);
   DoLoadDefFile(aEnvironment, &newInput,def);
 
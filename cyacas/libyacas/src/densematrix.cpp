@@ -0,0 +1,356 @@
+#include "yacas/densematrix.h"
+#include "yacas/lispatom.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/numbers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+/// Integer products are computed in machine words when the largest sum
+/// of products is smaller than this, which leaves a margin below 2^62
+/// for the rounding of its estimate in floating point.
+const double SmallProductLimit = 4.0e18;
+
+/// The size of the blocks of rows and columns the integer product works
+/// on, which keeps three blocks of machine words in the cache
+const std::size_t BlockSize = 64;
+
+/// Integers smaller than this in absolute value are exact as doubles
+const double ExactDoubleLimit = 9007199254740992.0;
+
+bool IsZero(LispEnvironment& aEnvironment, LispObject* aNumber)
+{
+    std::int64_t i;
+    if (aNumber->SmallInteger(i))
+        return i == 0;
+    // a zero computed by BigNumber may keep the sign of its operands,
+    // which Sign() reports, but Equals() does not compare
+    BigNumber zero;
+    zero.SetTo(0);
+    return aNumber->Number(aEnvironment.Precision())->Equals(zero);
+}
+
+bool IsInteger(LispEnvironment& aEnvironment, LispObject* aNumber)
+{
+    std::int64_t i;
+    if (aNumber->SmallInteger(i))
+        return true;
+    BigNumber* n = aNumber->Number(aEnvironment.Precision());
+    return n && n->IsInt();
+}
+
+LispObject* SmallNumber(LispEnvironment& aEnvironment, std::int64_t aValue)
+{
+    return new LispNumber(aValue, 0, aEnvironment.Precision());
+}
+
+/// The quotient of two integers, where aY divides aX
+LispObject* ExactQuotient(LispEnvironment& aEnvironment, LispObject* aX, LispObject* aY)
+{
+    std::int64_t a, b;
+    if (aX->SmallInteger(a) && aY->SmallInteger(b))
+        return SmallNumber(aEnvironment, a / b);
+
+    BigNumber* z = new BigNumber(aEnvironment.BinaryPrecision());
+    z->Divide(*aX->Number(aEnvironment.Precision()), *aY->Number(aEnvironment.Precision()), aEnvironment.BinaryPrecision());
+    return new LispNumber(z);
+}
+
+/// aX / aY, for aY nonzero, as the rules for / evaluate it in numeric
+/// mode: zero stays an exact zero, and integers lose their common
+/// factors before they are divided as floats
+LispObject* NumericQuotient(LispEnvironment& aEnvironment, LispObject* aX, LispObject* aY)
+{
+    if (IsZero(aEnvironment, aX))
+        return LispAtom::New(aEnvironment, "0");
+
+    if (IsInteger(aEnvironment, aX) && IsInteger(aEnvironment, aY)) {
+        LispPtr gcd(GcdInteger(aX, aY, aEnvironment));
+        BigNumber one;
+        one.SetTo(1);
+        if (!gcd->Number(0)->Equals(one)) {
+            LispPtr x(ExactQuotient(aEnvironment, aX, gcd));
+            LispPtr y(ExactQuotient(aEnvironment, aY, gcd));
+            return DivideNumbers(x, y, aEnvironment);
+        }
+    }
+
+    return DivideNumbers(aX, aY, aEnvironment);
+}
+
+/// Fraction-free elimination below the diagonal of the first
+/// aMatrix.Rows() columns, swapping rows when a pivot vanishes. Sets
+/// aOddSwaps if the rows were swapped an odd number of times. Returns
+/// false if the square part of aMatrix is singular.
+bool Eliminate(LispEnvironment& aEnvironment, DenseMatrix& aMatrix, bool& aOddSwaps)
+{
+    const std::size_t n = aMatrix.Rows();
+    const std::size_t m = aMatrix.Columns();
+
+    aOddSwaps = false;
+    LispPtr previous(SmallNumber(aEnvironment, 1));
+
+    for (std::size_t k = 0; k < n; ++k) {
+        if (IsZero(aEnvironment, aMatrix(k, k))) {
+            std::size_t r = k + 1;
+            while (r < n && IsZero(aEnvironment, aMatrix(r, k)))
+                ++r;
+            if (r == n)
+                return false;
+            for (std::size_t j = 0; j < m; ++j)
+                std::swap(aMatrix(k, j), aMatrix(r, j));
+            aOddSwaps = !aOddSwaps;
+        }
+
+        LispObject* pivot = aMatrix(k, k);
+        for (std::size_t i = k + 1; i < n; ++i) {
+            LispObject* factor = aMatrix(i, k);
+            for (std::size_t j = k + 1; j < m; ++j) {
+                LispPtr a(MultiplyNumbers(aMatrix(i, j), pivot, aEnvironment));
+                LispPtr b(MultiplyNumbers(factor, aMatrix(k, j), aEnvironment));
+                LispPtr difference(SubtractNumbers(a, b, aEnvironment));
+                aMatrix(i, j) = ExactQuotient(aEnvironment, difference, previous);
+            }
+            aMatrix(i, k) = SmallNumber(aEnvironment, 0);
+        }
+        previous = pivot;
+    }
+
+    return true;
+}
+
+}
+
+bool DenseMatrix::Read(LispEnvironment& aEnvironment, LispObject* aList)
+{
+    LispPtr* rows = aList->SubList();
+    if (!rows || !*rows || (*rows)->String() != aEnvironment.iList->String())
+        return false;
+
+    iRows = 0;
+    iColumns = 0;
+    iEntries.clear();
+
+    bool integers = false;
+    bool floats = false;
+
+    for (LispObject* row = (*rows)->Nixed(); row; row = row->Nixed()) {
+        LispPtr* entries = row->SubList();
+        if (!entries || !*entries || (*entries)->String() != aEnvironment.iList->String())
+            return false;
+
+        std::size_t columns = 0;
+        for (LispObject* p = (*entries)->Nixed(); p; p = p->Nixed(), ++columns) {
+            std::int64_t i;
+            LispObject* entry = p;
+            if (p->SmallInteger(i)) {
+                integers = true;
+            } else if (BigNumber* n = p->Number(aEnvironment.Precision())) {
+                if (n->IsInt()) {
+                    integers = true;
+                    // integers computed as BigNumbers, say by Lcm, are
+                    // taken as machine words when they are exact doubles
+                    const double d = n->Double();
+                    if (std::fabs(d) < ExactDoubleLimit)
+                        entry = SmallNumber(aEnvironment, static_cast<std::int64_t>(d));
+                } else {
+                    floats = true;
+                }
+            } else {
+                return false;
+            }
+            iEntries.push_back(LispPtr(entry));
+        }
+
+        if (iRows == 0)
+            iColumns = columns;
+        else if (columns != iColumns)
+            return false;
+
+        iRows += 1;
+    }
+
+    if (iRows == 0 || iColumns == 0)
+        return false;
+
+    iKind = !floats ? Integer : !integers ? Float : Mixed;
+
+    return true;
+}
+
+LispPtr DenseMatrix::ToList(LispEnvironment& aEnvironment) const
+{
+    LispPtr rows(aEnvironment.iList->Copy());
+    LispPtr* rowTail = &rows->Nixed();
+    for (std::size_t i = 0; i < iRows; ++i) {
+        LispPtr row(aEnvironment.iList->Copy());
+        LispPtr* tail = &row->Nixed();
+        for (std::size_t j = 0; j < iColumns; ++j) {
+            *tail = (*this)(i, j)->Copy();
+            tail = &(*tail)->Nixed();
+        }
+        *rowTail = LispSubList::New(row);
+        rowTail = &(*rowTail)->Nixed();
+    }
+    return LispPtr(LispSubList::New(rows));
+}
+
+DenseMatrix DenseMatrix::Multiply(LispEnvironment& aEnvironment, const DenseMatrix& aX, const DenseMatrix& aY)
+{
+    assert(aX.iColumns == aY.iRows);
+
+    const std::size_t n = aX.iRows;
+    const std::size_t m = aX.iColumns;
+    const std::size_t p = aY.iColumns;
+
+    DenseMatrix result(n, p);
+
+    if (aX.iKind == Integer && aY.iKind == Integer) {
+        std::vector<std::int64_t> x(n * m);
+        std::vector<std::int64_t> y(m * p);
+        double largestX = 0;
+        double largestY = 0;
+        bool small = true;
+        for (std::size_t i = 0; i < n * m && small; ++i) {
+            small = aX.iEntries[i]->SmallInteger(x[i]);
+            largestX = std::max(largestX, std::fabs(static_cast<double>(x[i])));
+        }
+        for (std::size_t i = 0; i < m * p && small; ++i) {
+            small = aY.iEntries[i]->SmallInteger(y[i]);
+            largestY = std::max(largestY, std::fabs(static_cast<double>(y[i])));
+        }
+
+        if (small && largestX * largestY * m < SmallProductLimit) {
+            std::vector<std::int64_t> r(n * p, 0);
+            for (std::size_t ii = 0; ii < n; ii += BlockSize)
+            for (std::size_t jj = 0; jj < m; jj += BlockSize)
+            for (std::size_t kk = 0; kk < p; kk += BlockSize) {
+                const std::size_t iEnd = std::min(ii + BlockSize, n);
+                const std::size_t jEnd = std::min(jj + BlockSize, m);
+                const std::size_t kEnd = std::min(kk + BlockSize, p);
+                for (std::size_t i = ii; i < iEnd; ++i)
+                    for (std::size_t j = jj; j < jEnd; ++j) {
+                        const std::int64_t a = x[i * m + j];
+                        const std::int64_t* b = &y[j * p];
+                        std::int64_t* c = &r[i * p];
+                        for (std::size_t k = kk; k < kEnd; ++k)
+                            c[k] += a * b[k];
+                    }
+            }
+
+            // the precisions MathAdd gives the sums
+            const int bin = aEnvironment.BinaryPrecision();
+            for (std::size_t i = 0; i < n * p; ++i)
+                result.iEntries[i] = new LispNumber(r[i], bin, bin);
+            return result;
+        }
+    }
+
+    // the sums in the order the script for matrix products adds up
+    // the products, starting from the zeros of a zero matrix
+    LispPtr zero(LispAtom::New(aEnvironment, "0"));
+    std::fill(result.iEntries.begin(), result.iEntries.end(), zero);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < m; ++j)
+            for (std::size_t k = 0; k < p; ++k) {
+                LispPtr product(MultiplyNumbers(aX(i, j), aY(j, k), aEnvironment));
+                result(i, k) = AddNumbers(result(i, k), product, aEnvironment);
+            }
+
+    result.iKind = aX.iKind == Integer && aY.iKind == Integer ? Integer : Mixed;
+
+    return result;
+}
+
+LispPtr DenseMatrix::Determinant(LispEnvironment& aEnvironment, DenseMatrix aMatrix)
+{
+    assert(aMatrix.iRows == aMatrix.iColumns && aMatrix.iKind == Integer);
+
+    bool oddSwaps;
+    if (!Eliminate(aEnvironment, aMatrix, oddSwaps))
+        return LispPtr(SmallNumber(aEnvironment, 0));
+
+    LispPtr determinant(aMatrix(aMatrix.iRows - 1, aMatrix.iColumns - 1));
+    if (oddSwaps) {
+        LispPtr zero(SmallNumber(aEnvironment, 0));
+        determinant = SubtractNumbers(zero, determinant, aEnvironment);
+    }
+    return determinant;
+}
+
+bool DenseMatrix::Solve(LispEnvironment& aEnvironment, const DenseMatrix& aMatrix, const DenseMatrix& aRight,
+                        LispPtr& aDenominator, DenseMatrix& aNumerators)
+{
+    assert(aMatrix.iRows == aMatrix.iColumns && aMatrix.iKind == Integer);
+    assert(aRight.iRows == aMatrix.iRows && aRight.iKind == Integer);
+
+    const std::size_t n = aMatrix.iRows;
+    const std::size_t m = aRight.iColumns;
+
+    DenseMatrix augmented(n, n + m);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j)
+            augmented(i, j) = aMatrix(i, j);
+        for (std::size_t j = 0; j < m; ++j)
+            augmented(i, n + j) = aRight(i, j);
+    }
+
+    bool oddSwaps;
+    if (!Eliminate(aEnvironment, augmented, oddSwaps))
+        return false;
+
+    // the rows are combinations of the equations, so that the solution
+    // times the last pivot is integer, and each step of the back
+    // substitution divides exactly
+    aDenominator = augmented(n - 1, n - 1);
+    aNumerators = DenseMatrix(n, m);
+    for (std::size_t c = 0; c < m; ++c)
+        for (std::size_t i = n; i-- > 0;) {
+            LispPtr sum(MultiplyNumbers(aDenominator, augmented(i, n + c), aEnvironment));
+            for (std::size_t j = i + 1; j < n; ++j) {
+                LispPtr product(MultiplyNumbers(augmented(i, j), aNumerators(j, c), aEnvironment));
+                sum = SubtractNumbers(sum, product, aEnvironment);
+            }
+            aNumerators(i, c) = ExactQuotient(aEnvironment, sum, augmented(i, i));
+        }
+
+    return true;
+}
+
+bool DenseMatrix::LU(LispEnvironment& aEnvironment, const DenseMatrix& aMatrix, DenseMatrix& aL, DenseMatrix& aU)
+{
+    assert(aMatrix.iRows == aMatrix.iColumns);
+
+    const std::size_t n = aMatrix.iRows;
+    DenseMatrix m(aMatrix);
+
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        if (IsZero(aEnvironment, m(i, i)))
+            return false;
+        for (std::size_t k = i + 1; k < n; ++k) {
+            m(k, i) = NumericQuotient(aEnvironment, m(k, i), m(i, i));
+            for (std::size_t j = i + 1; j < n; ++j) {
+                LispPtr product(MultiplyNumbers(m(k, i), m(i, j), aEnvironment));
+                m(k, j) = SubtractNumbers(m(k, j), product, aEnvironment);
+            }
+        }
+    }
+
+    LispPtr zero(LispAtom::New(aEnvironment, "0"));
+    LispPtr one(LispAtom::New(aEnvironment, "1"));
+    aL = DenseMatrix(n, n);
+    aU = DenseMatrix(n, n);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < n; ++j) {
+            aL(i, j) = i == j ? one : i > j ? m(i, j) : zero;
+            aU(i, j) = i <= j ? m(i, j) : zero;
+        }
+    aL.iKind = aU.iKind = Mixed;
+
+    return true;
+}
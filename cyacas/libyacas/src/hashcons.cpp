@@ -0,0 +1,85 @@
+#include "yacas/hashcons.h"
+#include "yacas/lispatom.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/standard.h"
+
+#include <algorithm>
+#include <vector>
+
+static const std::size_t MinSweepSize = 1024;
+
+HashConsTable::HashConsTable():
+    iLists(),
+    iSweepSize(MinSweepSize)
+{
+}
+
+LispPtr HashConsTable::Intern(LispEnvironment& aEnvironment, const LispPtr& aExpression)
+{
+    if (!aExpression || !aExpression->SubList() || !*aExpression->SubList())
+        return aExpression;
+
+    const LispPtr& list = *aExpression->SubList();
+    const std::size_t hash = InternalHash(aEnvironment, aExpression);
+    const bool exact = InternalHashIsExact(hash);
+
+    if (exact) {
+        auto range = iLists.equal_range(hash);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (!InternalEquals(aEnvironment, i->second, aExpression))
+                continue;
+            if (i->second->SubList()->ptr() == list.ptr())
+                return aExpression;
+            return LispPtr(i->second->Copy());
+        }
+    }
+
+    std::vector<LispPtr> elements;
+    bool changed = false;
+    for (LispIterator iter(*aExpression->SubList()); iter.getObj(); ++iter) {
+        elements.push_back(Intern(aEnvironment, *iter));
+        changed = changed || elements.back().ptr() != iter.getObj();
+    }
+
+    LispPtr result(aExpression);
+
+    if (changed) {
+        // the elements are linked in other lists, so link copies
+        LispPtr chain;
+        for (auto e = elements.rbegin(); e != elements.rend(); ++e) {
+            LispPtr copy((*e)->Copy());
+            copy->Nixed() = chain;
+            chain = copy;
+        }
+        LispSubList* sublist = LispSubList::New(chain.ptr());
+        sublist->CacheHash(aEnvironment.HashGeneration(), hash);
+        result = sublist;
+    }
+
+    if (exact) {
+        iLists.insert(std::make_pair(hash, LispPtr(result->Copy())));
+        if (iLists.size() >= iSweepSize)
+            Sweep();
+    }
+
+    return result;
+}
+
+void HashConsTable::Clear()
+{
+    iLists.clear();
+    iSweepSize = MinSweepSize;
+}
+
+void HashConsTable::Sweep()
+{
+    for (auto i = iLists.begin(); i != iLists.end();) {
+        // the elements of a list only the table holds
+        if (i->second->SubList()->ptr()->iReferenceCount == 1)
+            i = iLists.erase(i);
+        else
+            ++i;
+    }
+
+    iSweepSize = std::max(MinSweepSize, 2 * iLists.size());
+}
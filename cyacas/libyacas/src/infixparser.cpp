@@ -6,6 +6,7 @@
 #include "yacas/errors.h"
 #include "yacas/arrayclass.h"
 #include "yacas/associationclass.h"
+#include "yacas/packedarrayclass.h"
 
 #include <cassert>
 #include <string>
@@ -347,6 +348,19 @@ void InfixPrinter::Print(
             }
             WriteToken(aOutput, "}");
             WriteToken(aOutput, ")");
+        } else if (const PackedArrayClass* a = dynamic_cast<const PackedArrayClass*>(g)) {
+            // written as the call which creates it, so that it reads back
+            WriteToken(aOutput, "PackedArray'Create");
+            WriteToken(aOutput, "(");
+            WriteToken(aOutput, "{");
+            const std::size_t n = a->Size();
+            for (std::size_t i = 1; i <= n; ++i) {
+                Print(LispPtr(a->GetElement(*iCurrentEnvironment, i)), aOutput, KMaxPrecedence);
+                if (i != n)
+                    WriteToken(aOutput, ",");
+            }
+            WriteToken(aOutput, "}");
+            WriteToken(aOutput, ")");
         } else {
             WriteToken(aOutput, g->TypeName());
         }
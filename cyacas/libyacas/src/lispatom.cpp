@@ -119,10 +119,42 @@ GenericClass* LispGenericClass::Generic()
 // LispNumber methods - proceed at your own risk
 
 
+/// Decimal integers of at most this many digits fit in a machine word
+static const std::size_t SmallIntegerDigits = 18;
+
+LispNumber::LispNumber(LispString * aString, int aBasePrecision) :
+  iNumber(nullptr), iString(aString), iIsSmall(false), iSmall(0), iPrecision(0), iMantissaPrecision(aBasePrecision)
+{
+  const char* ptr = aString->c_str();
+  const bool negative = (*ptr == '-');
+  if (negative)
+    ptr++;
+
+  const char* digits = ptr;
+  std::int64_t value = 0;
+  while (*ptr >= '0' && *ptr <= '9')
+    value = 10 * value + (*ptr++ - '0');
+
+  // integer literals are held inline, anything else is converted right away
+  if (!*ptr && ptr != digits && std::size_t(ptr - digits) <= SmallIntegerDigits)
+  {
+    iIsSmall = true;
+    iSmall = negative ? -value : value;
+  }
+  else
+  {
+    Number(aBasePrecision);
+  }
+}
+
 /// return a string representation in decimal
 LispString * LispNumber::String()
 {
-  if (!iString)
+  if (!iString && iIsSmall)
+  {
+    iString = new LispString(std::to_string(iSmall));
+  }
+  else if (!iString)
   {
     assert(iNumber.ptr());  // either the string is null or the number but not both
     LispString *str = new LispString;
@@ -137,7 +169,12 @@ LispString * LispNumber::String()
 // Will create a BigNumber object out of a stored string, at given precision (in decimal) - that's why the aPrecision argument must be here - but only if no BigNumber object is already present
 BigNumber* LispNumber::Number(int aBasePrecision)
 {
-  if (!iNumber)
+  if (!iNumber && iIsSmall)
+  {
+    iNumber = new BigNumber;
+    iNumber->SetTo(iSmall, iPrecision, iMantissaPrecision);
+  }
+  else if (!iNumber)
   {  // create and store a BigNumber out of string
     assert(iString.ptr());
     RefPtr<LispString> str;
@@ -162,3 +199,9 @@ BigNumber* LispNumber::Number(int aBasePrecision)
   return iNumber;
 }
 
+bool LispNumber::SmallInteger(std::int64_t& aValue)
+{
+  if (iIsSmall)
+    aValue = iSmall;
+  return iIsSmall;
+}
@@ -10,6 +10,9 @@
 // we need this only for digits_to_bits
 #include "yacas/numbers.h"
 
+#include <algorithm>
+#include <limits>
+
 LispEnvironment::LispEnvironment(
                     YacasCoreCommands& aCoreCommands,
                     LispUserFunctions& aUserFunctions,
@@ -27,9 +30,14 @@ LispEnvironment::LispEnvironment(
     iPrecision(10),  // default user precision of 10 decimal digits
     iBinaryPrecision(34),  // same as 34 bits
     iInputDirectories(),
+    iCompileScripts(false),
+    iPatternBindings(),
     //iCleanup(),
     iEvalDepth(0),
     iMaxEvalDepth(1000),
+    iBudget(),
+    iEvalSteps(0),
+    iNextBudgetCheck(std::numeric_limits<unsigned long long>::max()),
     stop_evaluation(false),
     iEvaluator(new BasicEvaluator),
     iInputStatus(),
@@ -50,6 +58,15 @@ LispEnvironment::LispEnvironment(
     iProg(),
     iLastUniqueId(1),
     iDebugger(nullptr),
+    iDispatchCache(DispatchCacheSize, Dispatch{nullptr, 0, 0, nullptr, nullptr}),
+    iDispatchGeneration(1),
+    iHashGeneration(1),
+    iHashConsed(),
+    iDefinitionsGeneration(1),
+    iGlobalsGeneration(1),
+    iBudgetDeadline(),
+    iBudgetBytes(0),
+    iBudgetExceeded(nullptr),
     iInitialOutput(&aOutput),
     iCoreCommands(aCoreCommands),
     iUserFunctions(aUserFunctions),
@@ -101,6 +118,10 @@ LispEnvironment::LispEnvironment(
 
 LispEnvironment::~LispEnvironment()
 {
+    // the names of the variables may outlive the environment
+    while (!_local_frames.empty())
+        PopLocalFrame();
+
     delete iEvaluator;
     delete iDebugger;
 }
@@ -117,24 +138,62 @@ int LispEnvironment::GetUniqueId()
 }
 
 
-LispPtr* LispEnvironment::FindLocal(const LispString* aVariable)
+void LispEnvironment::StartBudget()
 {
-    assert(!_local_frames.empty());
+    iEvalSteps = 0;
+    iBudgetExceeded = nullptr;
 
-    std::size_t last = _local_vars.size();
+    if (iBudget.seconds > 0)
+        iBudgetDeadline = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(iBudget.seconds));
 
-    for (std::vector<LocalVariableFrame>::const_reverse_iterator f = _local_frames.rbegin(); f != _local_frames.rend(); ++f) {
-        const std::size_t first = f->first;
-        for (std::size_t i = last; i > first; --i)
-            if (_local_vars[i - 1].var == aVariable)
-                return &_local_vars[i - 1].val;
+    if (iBudget.bytes) {
+        const Arena::Statistics statistics = Arena::Current().GetStatistics();
+        iBudgetBytes = statistics.bytes + statistics.largeBytes + iBudget.bytes;
+    }
 
-        if (f->fenced)
-            break;
+    iNextBudgetCheck = 0;
+    CheckBudget();
+}
 
-        last = first;
+void LispEnvironment::CheckBudget()
+{
+    if (!iBudgetExceeded) {
+        if (iBudget.steps && iEvalSteps > iBudget.steps) {
+            iBudgetExceeded = "evaluation steps";
+        } else if (iBudget.seconds > 0 && std::chrono::steady_clock::now() >= iBudgetDeadline) {
+            iBudgetExceeded = "time";
+        } else if (iBudget.bytes) {
+            const Arena::Statistics statistics = Arena::Current().GetStatistics();
+            if (statistics.bytes + statistics.largeBytes > iBudgetBytes)
+                iBudgetExceeded = "memory";
+        }
     }
-    return nullptr;
+
+    if (iBudgetExceeded) {
+        iNextBudgetCheck = 0;
+        throw LispErrBudgetExceeded(iBudgetExceeded);
+    }
+
+    iNextBudgetCheck = std::numeric_limits<unsigned long long>::max();
+    if (iBudget.steps)
+        iNextBudgetCheck = iBudget.steps + 1;
+    if (iBudget.seconds > 0 || iBudget.bytes)
+        iNextBudgetCheck = std::min(iNextBudgetCheck, iEvalSteps + BudgetCheckInterval);
+}
+
+LispPtr* LispEnvironment::FindLocal(const LispString* aVariable)
+{
+    assert(!_local_frames.empty());
+
+    // bindings below the innermost fence are hidden, and so are all the
+    // older bindings of the variable
+    const std::size_t i = aVariable->iBinding;
+    if (i == LispString::NoBinding || i < _local_frames.back().fence)
+        return nullptr;
+
+    return &_local_vars[i].val;
 }
 
 void LispEnvironment::SetVariable(const LispString* aVariable, LispPtr& aValue, bool aGlobalLazyVariable)
@@ -156,6 +215,8 @@ void LispEnvironment::SetVariable(const LispString* aVariable, LispPtr& aValue,
 
     if (aGlobalLazyVariable)
         i->second.SetEvalBeforeReturn(true);
+
+    GlobalsChanged();
 }
 
 void LispEnvironment::GetVariable(const LispString* aVariable, LispPtr& aResult)
@@ -193,19 +254,43 @@ void LispEnvironment::UnsetVariable(const LispString* var)
         if (Protected(var))
             throw LispErrProtectedSymbol(*var);
         iGlobals.erase(var);
+        GlobalsChanged();
     }
 }
 
 void LispEnvironment::PushLocalFrame(bool fenced)
 {
-    _local_frames.emplace_back(_local_vars.size(), fenced);
+    const std::size_t first = _local_vars.size();
+    const std::size_t fence = (fenced || _local_frames.empty()) ? first : _local_frames.back().fence;
+
+    _local_frames.emplace_back(first, fenced, fence);
 }
 
 void LispEnvironment::PopLocalFrame()
 {
     assert(!_local_frames.empty());
 
-    _local_vars.erase(_local_vars.begin() + _local_frames.back().first, _local_vars.end());
+    const std::size_t first = _local_frames.back().first;
+
+    for (std::size_t i = _local_vars.size(); i > first; --i)
+        _local_vars[i - 1].var->iBinding = _local_vars[i - 1].hidden;
+
+    _local_vars.erase(_local_vars.begin() + first, _local_vars.end());
+    _local_frames.pop_back();
+}
+
+void LispEnvironment::MergeLocalFrame(std::size_t aCount)
+{
+    assert(_local_frames.size() > 1);
+
+    const std::size_t first = _local_frames.back().first;
+
+    assert(_local_vars.size() >= first + aCount);
+
+    for (std::size_t i = _local_vars.size(); i > first + aCount; --i)
+        _local_vars[i - 1].var->iBinding = _local_vars[i - 1].hidden;
+
+    _local_vars.erase(_local_vars.begin() + first + aCount, _local_vars.end());
     _local_frames.pop_back();
 }
 
@@ -213,7 +298,8 @@ void LispEnvironment::NewLocal(const LispString* var, LispObject* val)
 {
     assert(!_local_frames.empty());
 
-    _local_vars.emplace_back(var, val);
+    _local_vars.emplace_back(var, val, var->iBinding);
+    var->iBinding = _local_vars.size() - 1;
 }
 
 void LispEnvironment::CurrentLocals(LispPtr& aResult)
@@ -330,6 +416,8 @@ void LispEnvironment::UnFenceRule(const LispString* aOperator, int aArity)
         throw LispErrInvalidArg();
 
     userFunc->UnFence();
+
+    DefinitionsChanged();
 }
 
 void LispEnvironment::Retract(const LispString* aOperator, int aArity)
@@ -341,6 +429,8 @@ void LispEnvironment::Retract(const LispString* aOperator, int aArity)
 
     if (i != iUserFunctions.end())
         i->second.DeleteBase(aArity);
+
+    InvalidateDispatchCache();
 }
 
 void LispEnvironment::DeclareRuleBase(const LispString* aOperator,
@@ -366,6 +456,8 @@ void LispEnvironment::DeclareRuleBase(const LispString* aOperator,
             : new BranchingUserFunction(aParameters);
 
     multiUserFunc->DefineRuleBase(newFunc);
+
+    InvalidateDispatchCache();
 }
 
 void LispEnvironment::DeclareMacroRuleBase(const LispString* aOperator, LispPtr& aParameters, int aListed)
@@ -381,6 +473,8 @@ void LispEnvironment::DeclareMacroRuleBase(const LispString* aOperator, LispPtr&
             : new MacroUserFunction(aParameters);
 
     multiUserFunc->DefineRuleBase(newFunc);
+
+    InvalidateDispatchCache();
 }
 
 
@@ -409,16 +503,20 @@ void LispEnvironment::HoldArgument(const LispString*  aOperator, const LispStrin
     LispMultiUserFunction* multiUserFunc = &i->second;
 
     multiUserFunc->HoldArgument(aVariable);
+
+    DefinitionsChanged();
 }
 
 void LispEnvironment::Protect(const LispString* symbol)
 {
     protected_symbols.insert(symbol);
+    DefinitionsChanged();
 }
 
 void LispEnvironment::UnProtect(const LispString* symbol)
 {
     protected_symbols.erase(symbol);
+    DefinitionsChanged();
 }
 
 bool LispEnvironment::Protected(const LispString* symbol) const
@@ -457,6 +555,8 @@ void LispEnvironment::DefineRule(const LispString* aOperator,int aArity,
     }
     else
         userFunc->DeclareRule(aPrecedence, aPredicate,aBody);
+
+    DefinitionsChanged();
 }
 
 void LispEnvironment::DefineRulePattern(const LispString* aOperator,int aArity,
@@ -482,6 +582,8 @@ void LispEnvironment::DefineRulePattern(const LispString* aOperator,int aArity,
 
     // Declare a new evaluation rule
     userFunc->DeclarePattern(aPrecedence, aPredicate,aBody);
+
+    DefinitionsChanged();
 }
 
 void LispEnvironment::SetCommand(YacasEvalCaller aEvaluatorFunc, const char* aString,int aNrArgs,int aFlags)
@@ -493,11 +595,15 @@ void LispEnvironment::SetCommand(YacasEvalCaller aEvaluatorFunc, const char* aSt
       i->second = eval;
   else
       iCoreCommands.insert(std::make_pair(name, eval));
+
+  InvalidateDispatchCache();
 }
 
 void LispEnvironment::RemoveCoreCommand(char* aString)
 {
   iCoreCommands.erase(HashTable().LookUp(aString));
+
+  InvalidateDispatchCache();
 }
 
 LispLocalEvaluator::LispLocalEvaluator(LispEnvironment& aEnvironment,LispEvaluatorBase* aNewEvaluator)
@@ -34,6 +34,39 @@ LispUserFunction* GetUserFunction(LispEnvironment& aEnvironment,
   return userFunc;
 }
 
+// Find the core command or user function to evaluate a call with, in
+// the dispatch cache of the environment if it is there.
+static const LispEnvironment::Dispatch& Dispatch(LispEnvironment& aEnvironment, LispPtr* subList)
+{
+  const LispString* name = (*subList)->String();
+  const int arity = InternalListLength(*subList) - 1;
+
+  LispEnvironment::Dispatch& entry = aEnvironment.DispatchEntry(name, arity);
+  if (entry.iName == name && entry.iArity == arity &&
+      entry.iGeneration == aEnvironment.DispatchGeneration())
+    return entry;
+
+  // Finding the user function may load a file, and the entry is stale
+  // if that changes the functions.
+  const unsigned long generation = aEnvironment.DispatchGeneration();
+
+  const YacasEvaluator* coreCommand = nullptr;
+  LispUserFunction* userFunction = nullptr;
+
+  const auto i = aEnvironment.CoreCommands().find(name);
+  if (i != aEnvironment.CoreCommands().end())
+    coreCommand = &i->second;
+  else
+    userFunction = GetUserFunction(aEnvironment, subList);
+
+  entry.iName = name;
+  entry.iArity = arity;
+  entry.iGeneration = generation;
+  entry.iCoreCommand = coreCommand;
+  entry.iUserFunction = userFunction;
+  return entry;
+}
+
 UserStackInformation& LispEvaluatorBase::StackInformation()
 {
   return iBasicInfo;
@@ -60,6 +93,9 @@ void BasicEvaluator::Eval(LispEnvironment& aEnvironment, LispPtr& aResult, LispP
       throw LispErrUserInterrupt();
   }
 
+  if (++aEnvironment.iEvalSteps >= aEnvironment.iNextBudgetCheck)
+      aEnvironment.CheckBudget();
+
   aEnvironment.iEvalDepth++;
   if (aEnvironment.iEvalDepth >= aEnvironment.iMaxEvalDepth) {
       ShowStack(aEnvironment, aEnvironment.CurrentOutput());
@@ -98,22 +134,21 @@ void BasicEvaluator::Eval(LispEnvironment& aEnvironment, LispPtr& aResult, LispP
       {
         if (head->String())
         {
+          // the cache entry may be reused while the call is evaluated
+          const LispEnvironment::Dispatch& dispatch = Dispatch(aEnvironment, subList);
+          const YacasEvaluator* coreCommand = dispatch.iCoreCommand;
+          LispUserFunction* userFunc = dispatch.iUserFunction;
+
+          if (coreCommand)
           {
-              const auto i = aEnvironment.CoreCommands().find(head->String());
-              if (i != aEnvironment.CoreCommands().end()) {
-                  i->second.Evaluate(aResult, aEnvironment, *subList);
-                  goto FINISH;
-              }
+            coreCommand->Evaluate(aResult, aEnvironment, *subList);
+            goto FINISH;
           }
 
+          if (userFunc)
           {
-            LispUserFunction* userFunc;
-            userFunc = GetUserFunction(aEnvironment, subList);
-            if (userFunc)
-            {
-              userFunc->Evaluate(aResult,aEnvironment,*subList);
-              goto FINISH;
-            }
+            userFunc->Evaluate(aResult,aEnvironment,*subList);
+            goto FINISH;
           }
         }
         else
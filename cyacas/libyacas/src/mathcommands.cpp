@@ -12,8 +12,11 @@
 #include "yacas/mathuserfunc.h"
 #include "yacas/platmath.h"
 #include "yacas/numbers.h"
+#include "yacas/anumber.h"
 #include "yacas/arrayclass.h"
 #include "yacas/associationclass.h"
+#include "yacas/densematrix.h"
+#include "yacas/packedarrayclass.h"
 #include "yacas/patternclass.h"
 #include "yacas/substitute.h"
 #include "yacas/errors.h"
@@ -22,6 +25,7 @@
 
 #include <string>
 #include <cstring>
+#include <memory>
 #include <limits.h>
 #include <stdlib.h>
 #include <sstream>
@@ -162,11 +166,25 @@ void LispStrictTotalOrder(LispEnvironment& aEnvironment, int aStackTop)
 
 void LispLessThan(LispEnvironment& aEnvironment, int aStackTop)
 {
+    std::int64_t x, y;
+    if (ARGUMENT(1)->SmallInteger(x) && ARGUMENT(2)->SmallInteger(y))
+    {
+        InternalBoolean(aEnvironment, RESULT, x < y);
+        return;
+    }
+
     LispLexCompare2(aEnvironment, aStackTop, LexLessThan, BigLessThan);
 }
 
 void LispGreaterThan(LispEnvironment& aEnvironment, int aStackTop)
 {
+    std::int64_t x, y;
+    if (ARGUMENT(1)->SmallInteger(x) && ARGUMENT(2)->SmallInteger(y))
+    {
+        InternalBoolean(aEnvironment, RESULT, x > y);
+        return;
+    }
+
     LispLexCompare2(aEnvironment, aStackTop, LexGreaterThan, BigGreaterThan);
 }
 
@@ -219,6 +237,13 @@ void LispHead(LispEnvironment& aEnvironment, int aStackTop)
 
 void LispNth(LispEnvironment& aEnvironment, int aStackTop)
 {
+    std::int64_t n;
+    if (ARGUMENT(2)->SmallInteger(n) && n >= INT_MIN && n <= INT_MAX)
+    {
+        InternalNth(RESULT, ARGUMENT(1), static_cast<int>(n));
+        return;
+    }
+
     const LispString* str = ARGUMENT(2)->String();
     CheckArg(str, 2, aEnvironment, aStackTop);
     CheckArg(IsNumber(str->c_str(), false), 2, aEnvironment, aStackTop);
@@ -264,6 +289,7 @@ void LispDestructiveReverse(LispEnvironment& aEnvironment, int aStackTop)
 
   LispPtr reversed(aEnvironment.iList->Copy());
   InternalReverseList(reversed->Nixed(), (*ARGUMENT(1)->SubList())->Nixed());
+  aEnvironment.InvalidateHashes();
   RESULT = (LispSubList::New(reversed));
 }
 
@@ -283,7 +309,7 @@ void LispLength(LispEnvironment& aEnvironment, int aStackTop)
     } else
         CheckArg(false, 1, aEnvironment, aStackTop);
 
-    RESULT = LispAtom::New(aEnvironment, std::to_string(size));
+    RESULT = new LispNumber(static_cast<std::int64_t>(size), 0, aEnvironment.Precision());
 }
 
 void LispList(LispEnvironment& aEnvironment, int aStackTop)
@@ -345,6 +371,7 @@ static void InternalDelete(LispEnvironment& aEnvironment, int aStackTop, int aDe
     if (aDestructive)
     {
         copied = ((*evaluated->SubList()));
+        aEnvironment.InvalidateHashes();
     }
     else
     {
@@ -390,6 +417,11 @@ void LispFlatCopy(LispEnvironment& aEnvironment, int aStackTop)
     RESULT = (LispSubList::New(copied));
 }
 
+void LispHashCons(LispEnvironment& aEnvironment, int aStackTop)
+{
+    RESULT = aEnvironment.HashConsed().Intern(aEnvironment, ARGUMENT(1));
+}
+
 static void InternalInsert(LispEnvironment& aEnvironment, int aStackTop, int aDestructive)
 {
     CheckArgIsList(1, aEnvironment, aStackTop);
@@ -400,6 +432,7 @@ static void InternalInsert(LispEnvironment& aEnvironment, int aStackTop, int aDe
     if (aDestructive)
     {
         copied = ((*evaluated->SubList()));
+        aEnvironment.InvalidateHashes();
     }
     else
     {
@@ -446,6 +479,7 @@ static void InternalReplace(LispEnvironment& aEnvironment, int aStackTop, int aD
     if (aDestructive)
     {
         copied = ((*evaluated->SubList()));
+        aEnvironment.InvalidateHashes();
     }
     else
     {
@@ -694,6 +728,7 @@ static void MultiFix(LispEnvironment& aEnvironment, int aStackTop, LispOperators
     int prec = InternalAsciiToInt(*precedence->String());
     CheckArg(prec <= KMaxPrecedence, 2, aEnvironment, aStackTop);
     aOps[SymbolName(aEnvironment,*orig)] = LispInFixOperator(prec);
+    aEnvironment.DefinitionsChanged();
     InternalTrue(aEnvironment,RESULT);
 }
 
@@ -709,6 +744,7 @@ static void SingleFix(int aPrecedence, LispEnvironment& aEnvironment, int aStack
     const LispString* orig = ARGUMENT(1)->String();
     CheckArg(orig, 1, aEnvironment, aStackTop);
     aOps[SymbolName(aEnvironment,*orig)] = LispInFixOperator(aPrecedence);
+    aEnvironment.DefinitionsChanged();
     InternalTrue(aEnvironment,RESULT);
 }
 
@@ -1022,13 +1058,21 @@ void LispIsAtom(LispEnvironment& aEnvironment,int aStackTop)
 void LispIsNumber(LispEnvironment& aEnvironment,int aStackTop)
 {
   LispPtr result(ARGUMENT(1));
-  InternalBoolean(aEnvironment, RESULT, result->Number(aEnvironment.Precision()) != nullptr);
+  std::int64_t n;
+  InternalBoolean(aEnvironment, RESULT, result->SmallInteger(n) || result->Number(aEnvironment.Precision()) != nullptr);
 }
 
 void LispIsInteger(LispEnvironment& aEnvironment,int aStackTop)
 {
   LispPtr result(ARGUMENT(1));
 
+  std::int64_t n;
+  if (result->SmallInteger(n))
+  {
+    InternalTrue(aEnvironment,RESULT);
+    return;
+  }
+
   RefPtr<BigNumber> num ; num = result->Number(aEnvironment.Precision());
   if (!num)
   {
@@ -1268,6 +1312,9 @@ void LispTrapError(LispEnvironment& aEnvironment,int aStackTop)
 {
     try {
         InternalEval(aEnvironment, RESULT, ARGUMENT(1));
+    } catch (const LispErrBudgetExceeded&) {
+        // the budget is that of the evaluation as a whole
+        throw;
     } catch (const LispError& error) {
         HandleError(error, aEnvironment, aEnvironment.iErrorOutput);
     }
@@ -1321,6 +1368,7 @@ void LispMaxEvalDepth(LispEnvironment& aEnvironment, int aStackTop)
 
     int ind = InternalAsciiToInt(*index->String());
     aEnvironment.iMaxEvalDepth = ind;
+    aEnvironment.DefinitionsChanged();
     InternalTrue(aEnvironment,RESULT);
 }
 
@@ -1363,7 +1411,8 @@ void LispRightAssociative(LispEnvironment& aEnvironment, int aStackTop)
     if (opi == aEnvironment.InFix().end())
         throw LispErrNotAnInFixOperator();
     opi->second.SetRightAssociative();
-    
+    aEnvironment.DefinitionsChanged();
+
     InternalTrue(aEnvironment,RESULT);
 }
 
@@ -1384,6 +1433,7 @@ void LispLeftPrecedence(LispEnvironment& aEnvironment, int aStackTop)
     if (opi == aEnvironment.InFix().end())
         throw LispErrNotAnInFixOperator();
     opi->second.SetLeftPrecedence(ind);
+    aEnvironment.DefinitionsChanged();
 
     InternalTrue(aEnvironment,RESULT);
 }
@@ -1405,6 +1455,7 @@ void LispRightPrecedence(LispEnvironment& aEnvironment, int aStackTop)
     if (opi == aEnvironment.InFix().end())
         throw LispErrNotAnInFixOperator();
     opi->second.SetRightPrecedence(ind);
+    aEnvironment.DefinitionsChanged();
 
     InternalTrue(aEnvironment,RESULT);
 }
@@ -1534,6 +1585,38 @@ void YacasBuiltinPrecisionGet(LispEnvironment& aEnvironment, int aStackTop)
     RESULT = LispAtom::New(aEnvironment, std::to_string(aEnvironment.Precision()));
 }
 
+void YacasBuiltinMultiplyThresholdsSet(LispEnvironment& aEnvironment, int aStackTop)
+{
+    MultiplyThresholds thresholds;
+
+    int* const values[] = { &thresholds.karatsuba, &thresholds.toom3, &thresholds.ntt };
+    for (int i = 1; i <= 3; ++i) {
+        LispPtr arg(ARGUMENT(i));
+        CheckArg(arg->String(), i, aEnvironment, aStackTop);
+        const int value = InternalAsciiToInt(*arg->String());
+        CheckArg(value > 0, i, aEnvironment, aStackTop);
+        *values[i - 1] = value;
+    }
+
+    SetMultiplyThresholds(thresholds);
+    InternalTrue(aEnvironment,RESULT);
+}
+
+void YacasBuiltinMultiplyThresholdsGet(LispEnvironment& aEnvironment, int aStackTop)
+{
+    const MultiplyThresholds thresholds = GetMultiplyThresholds();
+
+    LispPtr all(aEnvironment.iList->Copy());
+    LispIterator tail(all);
+    ++tail;
+    (*tail) = LispAtom::New(aEnvironment, std::to_string(thresholds.karatsuba));
+    ++tail;
+    (*tail) = LispAtom::New(aEnvironment, std::to_string(thresholds.toom3));
+    ++tail;
+    (*tail) = LispAtom::New(aEnvironment, std::to_string(thresholds.ntt));
+    RESULT = LispSubList::New(all);
+}
+
 void LispToString(LispEnvironment& aEnvironment, int aStackTop)
 {
     std::ostringstream os;
@@ -1655,13 +1738,27 @@ void GenArraySet(LispEnvironment& aEnvironment,int aStackTop)
   CheckArg(size > 0 && static_cast<std::size_t>(size) <= arr->Size(), 2, aEnvironment, aStackTop);
   LispPtr obj(ARGUMENT(3));
   arr->SetElement(size,obj);
+  // the array may be the value of a global
+  aEnvironment.GlobalsChanged();
 
   InternalTrue( aEnvironment, RESULT);
 }
 
 void GenAssociationCreate(LispEnvironment& aEnvironment,int aStackTop)
 {
-    AssociationClass* a = new AssociationClass(aEnvironment);
+    // the optional backend
+    AssociationClass::Backend backend = AssociationClass::Sorted;
+    LispPtr* rest = ARGUMENT(1)->SubList();
+    CheckArg(rest && *rest, 1, aEnvironment, aStackTop);
+    if (LispObject* name = (*rest)->Nixed()) {
+        CheckArg(name->String() && !name->Nixed(), 1, aEnvironment, aStackTop);
+        const std::string s = InternalUnstringify(*name->String());
+        CheckArg(s == "Sorted" || s == "Hashed", 1, aEnvironment, aStackTop);
+        if (s == "Hashed")
+            backend = AssociationClass::Hashed;
+    }
+
+    AssociationClass* a = new AssociationClass(aEnvironment, backend);
     RESULT = LispGenericClass::New(a);
 }
 
@@ -1717,6 +1814,7 @@ void GenAssociationSet(LispEnvironment& aEnvironment,int aStackTop)
   LispPtr v(ARGUMENT(3));
 
   a->SetElement(k, v);
+  aEnvironment.GlobalsChanged();
 
   InternalTrue( aEnvironment, RESULT);
 }
@@ -1729,6 +1827,7 @@ void GenAssociationDrop(LispEnvironment& aEnvironment,int aStackTop)
     CheckArg(a, 1, aEnvironment, aStackTop);
 
     LispPtr k(ARGUMENT(2));
+    aEnvironment.GlobalsChanged();
     if (a->DropElement(k))
         InternalTrue(aEnvironment,RESULT);
     else
@@ -1766,6 +1865,183 @@ void GenAssociationHead(LispEnvironment& aEnvironment,int aStackTop)
     RESULT = a->Head();
 }
 
+static PackedArrayClass* PackedArrayArgument(LispEnvironment& aEnvironment, int aStackTop, int aArgNr)
+{
+    PackedArrayClass* a = dynamic_cast<PackedArrayClass*>(ARGUMENT(aArgNr)->Generic());
+    CheckArg(a, aArgNr, aEnvironment, aStackTop);
+    return a;
+}
+
+void GenPackedArrayPackable(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayClass::Type type;
+    if (!PackedArrayClass::Packable(aEnvironment, ARGUMENT(1), type))
+        InternalFalse(aEnvironment, RESULT);
+    else if (type == PackedArrayClass::Integer)
+        RESULT = LispAtom::New(aEnvironment, "\"Integer\"");
+    else
+        RESULT = LispAtom::New(aEnvironment, "\"Float\"");
+}
+
+void GenPackedArrayCreate(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayClass::Type type;
+    CheckArg(PackedArrayClass::Packable(aEnvironment, ARGUMENT(1), type), 1, aEnvironment, aStackTop);
+    RESULT = LispGenericClass::New(PackedArrayClass::FromList(aEnvironment, ARGUMENT(1)));
+}
+
+void GenPackedArraySize(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayClass* a = PackedArrayArgument(aEnvironment, aStackTop, 1);
+    RESULT = LispAtom::New(aEnvironment, std::to_string(a->Size()));
+}
+
+void GenPackedArrayGet(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayClass* a = PackedArrayArgument(aEnvironment, aStackTop, 1);
+
+    LispPtr sizearg(ARGUMENT(2));
+    CheckArg(sizearg->String(), 2, aEnvironment, aStackTop);
+    const int i = InternalAsciiToInt(*sizearg->String());
+    CheckArg(i > 0 && static_cast<std::size_t>(i) <= a->Size(), 2, aEnvironment, aStackTop);
+
+    RESULT = a->GetElement(aEnvironment, i);
+}
+
+void GenPackedArrayToList(LispEnvironment& aEnvironment,int aStackTop)
+{
+    RESULT = PackedArrayArgument(aEnvironment, aStackTop, 1)->ToList(aEnvironment);
+}
+
+// Either argument may be a number, which stands for an array of copies
+static void PackedArrayElementwise(LispEnvironment& aEnvironment, int aStackTop, PackedArrayClass::Operation aOperation)
+{
+    PackedArrayClass* x = dynamic_cast<PackedArrayClass*>(ARGUMENT(1)->Generic());
+    PackedArrayClass* y = dynamic_cast<PackedArrayClass*>(ARGUMENT(2)->Generic());
+    CheckArg(x || y, 1, aEnvironment, aStackTop);
+
+    std::unique_ptr<PackedArrayClass> filled;
+    if (!x) {
+        filled.reset(PackedArrayClass::Fill(aEnvironment, ARGUMENT(1), y->Size()));
+        CheckArg(filled != nullptr, 1, aEnvironment, aStackTop);
+        x = filled.get();
+    } else if (!y) {
+        filled.reset(PackedArrayClass::Fill(aEnvironment, ARGUMENT(2), x->Size()));
+        CheckArg(filled != nullptr, 2, aEnvironment, aStackTop);
+        y = filled.get();
+    }
+    CheckArg(x->Size() == y->Size(), 2, aEnvironment, aStackTop);
+
+    RESULT = LispGenericClass::New(PackedArrayClass::Elementwise(aOperation, *x, *y));
+}
+
+void GenPackedArrayAdd(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayElementwise(aEnvironment, aStackTop, PackedArrayClass::Add);
+}
+
+void GenPackedArraySubtract(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayElementwise(aEnvironment, aStackTop, PackedArrayClass::Subtract);
+}
+
+void GenPackedArrayMultiply(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayElementwise(aEnvironment, aStackTop, PackedArrayClass::Multiply);
+}
+
+void GenPackedArrayDivide(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayElementwise(aEnvironment, aStackTop, PackedArrayClass::Divide);
+}
+
+void GenPackedArraySum(LispEnvironment& aEnvironment,int aStackTop)
+{
+    RESULT = PackedArrayArgument(aEnvironment, aStackTop, 1)->Sum(aEnvironment);
+}
+
+void GenPackedArrayDot(LispEnvironment& aEnvironment,int aStackTop)
+{
+    PackedArrayClass* x = PackedArrayArgument(aEnvironment, aStackTop, 1);
+    PackedArrayClass* y = PackedArrayArgument(aEnvironment, aStackTop, 2);
+    CheckArg(x->Size() == y->Size(), 2, aEnvironment, aStackTop);
+    RESULT = x->Dot(aEnvironment, *y);
+}
+
+static void MatrixArgument(DenseMatrix& aMatrix, LispEnvironment& aEnvironment, int aStackTop, int aArgNr)
+{
+    CheckArg(aMatrix.Read(aEnvironment, ARGUMENT(aArgNr)), aArgNr, aEnvironment, aStackTop);
+}
+
+void LispMatrixNumeric(LispEnvironment& aEnvironment,int aStackTop)
+{
+    DenseMatrix m;
+    if (!m.Read(aEnvironment, ARGUMENT(1)))
+        InternalFalse(aEnvironment, RESULT);
+    else if (m.GetKind() == DenseMatrix::Integer)
+        RESULT = LispAtom::New(aEnvironment, "\"Integer\"");
+    else if (m.GetKind() == DenseMatrix::Float)
+        RESULT = LispAtom::New(aEnvironment, "\"Float\"");
+    else
+        RESULT = LispAtom::New(aEnvironment, "\"Mixed\"");
+}
+
+void LispMatrixMultiply(LispEnvironment& aEnvironment,int aStackTop)
+{
+    DenseMatrix x, y;
+    MatrixArgument(x, aEnvironment, aStackTop, 1);
+    MatrixArgument(y, aEnvironment, aStackTop, 2);
+    CheckArg(x.Columns() == y.Rows(), 2, aEnvironment, aStackTop);
+    RESULT = DenseMatrix::Multiply(aEnvironment, x, y).ToList(aEnvironment);
+}
+
+void LispMatrixDeterminant(LispEnvironment& aEnvironment,int aStackTop)
+{
+    DenseMatrix m;
+    MatrixArgument(m, aEnvironment, aStackTop, 1);
+    CheckArg(m.Rows() == m.Columns() && m.GetKind() == DenseMatrix::Integer, 1, aEnvironment, aStackTop);
+    RESULT = DenseMatrix::Determinant(aEnvironment, m);
+}
+
+void LispMatrixSolve(LispEnvironment& aEnvironment,int aStackTop)
+{
+    DenseMatrix m, right;
+    MatrixArgument(m, aEnvironment, aStackTop, 1);
+    MatrixArgument(right, aEnvironment, aStackTop, 2);
+    CheckArg(m.Rows() == m.Columns() && m.GetKind() == DenseMatrix::Integer, 1, aEnvironment, aStackTop);
+    CheckArg(right.Rows() == m.Rows() && right.GetKind() == DenseMatrix::Integer, 2, aEnvironment, aStackTop);
+
+    LispPtr denominator;
+    DenseMatrix numerators;
+    if (!DenseMatrix::Solve(aEnvironment, m, right, denominator, numerators)) {
+        InternalFalse(aEnvironment, RESULT);
+        return;
+    }
+
+    LispPtr list(aEnvironment.iList->Copy());
+    list->Nixed() = denominator;
+    list->Nixed()->Nixed() = numerators.ToList(aEnvironment);
+    RESULT = LispSubList::New(list);
+}
+
+void LispMatrixLU(LispEnvironment& aEnvironment,int aStackTop)
+{
+    DenseMatrix m;
+    MatrixArgument(m, aEnvironment, aStackTop, 1);
+    CheckArg(m.Rows() == m.Columns(), 1, aEnvironment, aStackTop);
+
+    DenseMatrix l, u;
+    if (!DenseMatrix::LU(aEnvironment, m, l, u)) {
+        InternalFalse(aEnvironment, RESULT);
+        return;
+    }
+
+    LispPtr list(aEnvironment.iList->Copy());
+    list->Nixed() = l.ToList(aEnvironment);
+    list->Nixed()->Nixed() = u.ToList(aEnvironment);
+    RESULT = LispSubList::New(list);
+}
+
 void LispCustomEval(LispEnvironment& aEnvironment,int aStackTop)
 {
   if (aEnvironment.iDebugger) delete aEnvironment.iDebugger;
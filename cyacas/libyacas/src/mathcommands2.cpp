@@ -58,7 +58,9 @@ void LispLocalSymbols(LispEnvironment& aEnvironment, int aStackTop)
     LispPtr result;
     InternalSubstitute(result, Argument(ARGUMENT(0), nrArguments-1), behaviour);
 
-    InternalEval(aEnvironment, RESULT, result);
+    LispPtr evaluated;
+    InternalEval(aEnvironment, evaluated, result);
+    InternalDeepCopy(RESULT, evaluated);
 }
 
 
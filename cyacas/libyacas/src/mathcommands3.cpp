@@ -17,8 +17,15 @@
 #include "yacas/errors.h"
 #include "yacas/patcher.h"
 #include "yacas/string_utils.h"
+#include "yacas/snapshot.h"
+#include "yacas/parallel.h"
+#include "yacas/arggetter.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
 
 #include "yacas/yacas_version.h"
 
@@ -43,6 +50,31 @@ void GetNumber(RefPtr<BigNumber>& x, LispEnvironment& aEnvironment, int aStackTo
     CheckArg(x, aArgNr, aEnvironment, aStackTop);
 }
 
+/// Sums, differences and products of integers smaller than this in
+/// absolute value are computed in machine words when they fit.
+static const std::int64_t SmallOperandLimit = std::int64_t(1) << 62;
+
+/// Get an argument that is an integer held in a machine word.
+/// \param x (on output) the value of the argument
+/// \return the argument, or nullptr if it is not such an integer
+static LispNumber* GetSmallInteger(std::int64_t& x, LispEnvironment& aEnvironment, int aStackTop, int aArgNr)
+{
+    LispObject* object = ARGUMENT(aArgNr).ptr();
+    if (!object->SmallInteger(x) || x <= -SmallOperandLimit || x >= SmallOperandLimit)
+      return nullptr;
+    // only LispNumber holds small integers
+    return static_cast<LispNumber*>(object);
+}
+
+/// Raise the error for the argument of a binary arithmetic function
+/// which is not a number
+static void CheckNumbers(LispEnvironment& aEnvironment, int aStackTop)
+{
+    RefPtr<BigNumber> x;
+    GetNumber(x, aEnvironment, aStackTop, 1);
+    GetNumber(x, aEnvironment, aStackTop, 2);
+}
+
 //FIXME remove these
 void LispArithmetic2(LispEnvironment& aEnvironment, int aStackTop,
                      LispObject* (*func)(LispObject* f1, LispObject* f2,LispEnvironment& aEnvironment,int aPrecision),
@@ -91,14 +123,10 @@ void LispDumpBigNumberDebugInfo(LispEnvironment& aEnvironment, int aStackTop)
 
 void LispMultiply(LispEnvironment& aEnvironment, int aStackTop)
 {
-      RefPtr<BigNumber> x;
-      RefPtr<BigNumber> y;
-      GetNumber(x,aEnvironment, aStackTop, 1);
-      GetNumber(y,aEnvironment, aStackTop, 2);
-      BigNumber *z = new BigNumber(aEnvironment.BinaryPrecision());
-      z->Multiply(*x, *y, aEnvironment.BinaryPrecision());
-      RESULT = new LispNumber(z);
-      return;
+      LispObject* product = MultiplyNumbers(ARGUMENT(1), ARGUMENT(2), aEnvironment);
+      if (!product)
+        CheckNumbers(aEnvironment, aStackTop);
+      RESULT = product;
 }
 
 //TODO we need to have Gcd in BigNumber!
@@ -122,6 +150,13 @@ void LispAdd(LispEnvironment& aEnvironment, int aStackTop)
     int length = InternalListLength(ARGUMENT(0));
     if (length == 2)
     {
+      std::int64_t a;
+      if (LispNumber* na = GetSmallInteger(a, aEnvironment, aStackTop, 1))
+      {
+        RESULT = new LispNumber(a, na->SmallPrecision(), na->SmallMantissaPrecision());
+        return;
+      }
+
       RefPtr<BigNumber> x;
       GetNumber(x,aEnvironment, aStackTop, 1);
       RESULT = (new LispNumber(x.ptr()));
@@ -129,15 +164,10 @@ void LispAdd(LispEnvironment& aEnvironment, int aStackTop)
     }
     else
     {
-      RefPtr<BigNumber> x;
-      RefPtr<BigNumber> y;
-      GetNumber(x,aEnvironment, aStackTop, 1);
-      GetNumber(y,aEnvironment, aStackTop, 2);
-      int bin = aEnvironment.BinaryPrecision();
-      BigNumber *z = new BigNumber(bin);
-      z->Add(*x.ptr(),*y.ptr(),aEnvironment.BinaryPrecision());
-      RESULT = (new LispNumber(z));
-      return;
+      LispObject* sum = AddNumbers(ARGUMENT(1), ARGUMENT(2), aEnvironment);
+      if (!sum)
+        CheckNumbers(aEnvironment, aStackTop);
+      RESULT = sum;
     }
 }
 
@@ -146,6 +176,13 @@ void LispSubtract(LispEnvironment& aEnvironment, int aStackTop)
     int length = InternalListLength(ARGUMENT(0));
     if (length == 2)
     {
+      std::int64_t a;
+      if (LispNumber* na = GetSmallInteger(a, aEnvironment, aStackTop, 1))
+      {
+        RESULT = new LispNumber(-a, na->SmallPrecision(), na->SmallMantissaPrecision());
+        return;
+      }
+
       RefPtr<BigNumber> x;
       GetNumber(x,aEnvironment, aStackTop, 1);
       BigNumber *z = new BigNumber(*x/*aEnvironment.BinaryPrecision()*/);
@@ -155,47 +192,20 @@ void LispSubtract(LispEnvironment& aEnvironment, int aStackTop)
     }
     else
     {
-      RefPtr<BigNumber> x;
-      RefPtr<BigNumber> y;
-      GetNumber(x,aEnvironment, aStackTop, 1);
-      GetNumber(y,aEnvironment, aStackTop, 2);
-      BigNumber yneg(*y);
-      yneg.Negate(yneg);
-      BigNumber *z = new BigNumber(aEnvironment.BinaryPrecision());
-      z->Add(*x,yneg,aEnvironment.BinaryPrecision());
-      RESULT = (new LispNumber(z));
-      return;
+      LispObject* difference = SubtractNumbers(ARGUMENT(1), ARGUMENT(2), aEnvironment);
+      if (!difference)
+        CheckNumbers(aEnvironment, aStackTop);
+      RESULT = difference;
     }
 }
 
 
 void LispDivide(LispEnvironment& aEnvironment, int aStackTop)
 {
-  // Serge, what was the deal again with divide, floats and integers mixed in the same function?
-  //  yes, divide works differently on integers and on floats -- see new.chapt -- Serge
-  RefPtr<BigNumber> x;
-  RefPtr<BigNumber> y;
-  GetNumber(x,aEnvironment, aStackTop, 1);
-  GetNumber(y,aEnvironment, aStackTop, 2);
-  BigNumber *z = new BigNumber(aEnvironment.BinaryPrecision());
-  // if both arguments are integers, then BigNumber::Divide would perform an integer divide, but we want a float divide here.
-  if (x->IsInt() && y->IsInt())
-  {
-    // why can't we just say BigNumber temp; ?
-    BigNumber tempx(aEnvironment.BinaryPrecision());
-    tempx.SetTo(*x);  // was: *x.Ptr()
-    tempx.BecomeFloat(aEnvironment.BinaryPrecision());  // coerce x to float
-    BigNumber tempy(aEnvironment.BinaryPrecision());
-    tempy.SetTo(*y);
-    tempy.BecomeFloat(aEnvironment.BinaryPrecision());  // coerce x to float
-    z->Divide(tempx, tempy,aEnvironment.BinaryPrecision());
-  }
-  else
-  {
-    z->Divide(*x, *y,aEnvironment.BinaryPrecision());
-  }
-  RESULT = (new LispNumber(z));
-  return;
+  LispObject* quotient = DivideNumbers(ARGUMENT(1), ARGUMENT(2), aEnvironment);
+  if (!quotient)
+    CheckNumbers(aEnvironment, aStackTop);
+  RESULT = quotient;
 }
 
 void LispSqrt(LispEnvironment& aEnvironment, int aStackTop)
@@ -575,6 +585,85 @@ void LispGarbageCollect(LispEnvironment& aEnvironment, int aStackTop)
   InternalTrue(aEnvironment,RESULT);
 }
 
+void LispMemoryStatistics(LispEnvironment& aEnvironment, int aStackTop)
+{
+  const Arena::Statistics statistics = Arena::Current().GetStatistics();
+
+  const std::pair<const char*, std::size_t> values[] = {
+    { "\"allocations\"", statistics.allocations },
+    { "\"blocks\"", statistics.blocks },
+    { "\"bytes\"", statistics.bytes },
+    { "\"large\"", statistics.large },
+    { "\"largebytes\"", statistics.largeBytes },
+    { "\"chunks\"", statistics.chunks },
+    { "\"reserved\"", statistics.reserved }
+  };
+
+  LispObject* info = nullptr;
+  for (std::size_t i = sizeof values / sizeof values[0]; i-- > 0; )
+    info = LispSubList::New(LispObjectAdder(aEnvironment.iList->Copy()) + LispObjectAdder(LispAtom::New(aEnvironment, values[i].first)) + LispObjectAdder(LispAtom::New(aEnvironment, std::to_string(values[i].second)))) + LispObjectAdder(info);
+
+  RESULT = LispSubList::New(LispObjectAdder(aEnvironment.iList->Copy()) + LispObjectAdder(info));
+}
+
+// The function named by the first argument, with the arity given by the
+// second, which must be defined by rules
+static BranchingUserFunction* RuleBase(LispEnvironment& aEnvironment, int aStackTop)
+{
+  LispPtr evaluated(ARGUMENT(1));
+  CheckArg(evaluated, 1, aEnvironment, aStackTop);
+  const LispString* orig = evaluated->String();
+  CheckArg(orig, 1, aEnvironment, aStackTop);
+  const LispString* oper = SymbolName(aEnvironment, *orig);
+
+  LispPtr arity(ARGUMENT(2));
+  CheckArg(arity->String(), 2, aEnvironment, aStackTop);
+  const int ar = InternalAsciiToInt(*arity->String());
+
+  LispUserFunction* userFunc = aEnvironment.UserFunction(oper, ar);
+  BranchingUserFunction* function = dynamic_cast<BranchingUserFunction*>(userFunc);
+  CheckArg(function && !dynamic_cast<MacroUserFunction*>(userFunc), 1, aEnvironment, aStackTop);
+
+  return function;
+}
+
+void LispMemoize(LispEnvironment& aEnvironment, int aStackTop)
+{
+  BranchingUserFunction* function = RuleBase(aEnvironment, aStackTop);
+
+  // the optional capacity
+  std::size_t capacity = 10000;
+  LispPtr* rest = ARGUMENT(3)->SubList();
+  CheckArg(rest && *rest, 3, aEnvironment, aStackTop);
+  if (LispObject* size = (*rest)->Nixed()) {
+    CheckArg(size->String() && !size->Nixed(), 3, aEnvironment, aStackTop);
+    const int n = InternalAsciiToInt(*size->String());
+    CheckArg(n >= 0, 3, aEnvironment, aStackTop);
+    capacity = n;
+  }
+
+  function->Memoize(capacity);
+  InternalTrue(aEnvironment, RESULT);
+}
+
+void LispMemoizeStatistics(LispEnvironment& aEnvironment, int aStackTop)
+{
+  const MemoTable* memo = RuleBase(aEnvironment, aStackTop)->Memo();
+
+  const std::pair<const char*, std::size_t> values[] = {
+    { "\"capacity\"", memo ? memo->Capacity() : 0 },
+    { "\"size\"", memo ? memo->Size() : 0 },
+    { "\"hits\"", memo ? memo->Hits() : 0 },
+    { "\"misses\"", memo ? memo->Misses() : 0 }
+  };
+
+  LispObject* info = nullptr;
+  for (std::size_t i = sizeof values / sizeof values[0]; i-- > 0; )
+    info = LispSubList::New(LispObjectAdder(aEnvironment.iList->Copy()) + LispObjectAdder(LispAtom::New(aEnvironment, values[i].first)) + LispObjectAdder(LispAtom::New(aEnvironment, std::to_string(values[i].second)))) + LispObjectAdder(info);
+
+  RESULT = LispSubList::New(LispObjectAdder(aEnvironment.iList->Copy()) + LispObjectAdder(info));
+}
+
 void LispPatchLoad(LispEnvironment& aEnvironment, int aStackTop)
 {
     LispPtr evaluated(ARGUMENT(1));
@@ -610,6 +699,51 @@ void LispPatchString(LispEnvironment& aEnvironment, int aStackTop)
   RESULT = LispAtom::New(aEnvironment, stringify(os.str()));
 }
 
+void LispSnapshotSave(LispEnvironment& aEnvironment, int aStackTop)
+{
+  CheckSecure(aEnvironment, aStackTop);
+
+  LispPtr evaluated(ARGUMENT(1));
+  const LispString* string = evaluated->String();
+  CheckArg(string, 1, aEnvironment, aStackTop);
+  const std::string fname = InternalUnstringify(*string);
+
+  std::ofstream file(fname, std::ios::binary);
+  if (!file)
+    throw LispErrFileNotFound();
+
+  SaveSnapshot(aEnvironment, file);
+  InternalTrue(aEnvironment, RESULT);
+}
+
+void LispSnapshotLoad(LispEnvironment& aEnvironment, int aStackTop)
+{
+  CheckSecure(aEnvironment, aStackTop);
+
+  LispPtr evaluated(ARGUMENT(1));
+  const LispString* string = evaluated->String();
+  CheckArg(string, 1, aEnvironment, aStackTop);
+  const std::string fname = InternalUnstringify(*string);
+
+  // a missing snapshot is not an error, the caller loads the scripts
+  // instead
+  const std::string path = InternalFindFile(fname.c_str(), aEnvironment.iInputDirectories);
+  std::ifstream file(path, std::ios::binary);
+
+  InternalBoolean(aEnvironment, RESULT, !path.empty() && file && LoadSnapshot(aEnvironment, file));
+}
+
+void LispParallelMap(LispEnvironment& aEnvironment, int aStackTop)
+{
+  LispPtr list(ARGUMENT(2));
+  CheckArgIsList(2, aEnvironment, aStackTop);
+
+  const int workers = GetShortIntegerArgument(aEnvironment, aStackTop, 3);
+  CheckArg(workers >= 0, 3, aEnvironment, aStackTop);
+
+  RESULT = ParallelMap(aEnvironment, ARGUMENT(1), list, workers);
+}
+
 void LispDefaultTokenizer(LispEnvironment& aEnvironment, int aStackTop)
 {
   aEnvironment.iCurrentTokenizer = &aEnvironment.iDefaultTokenizer;
@@ -756,7 +890,9 @@ void LispBackQuote(LispEnvironment& aEnvironment, int aStackTop)
     BackQuoteBehaviour behaviour(aEnvironment);
     LispPtr result;
     InternalSubstitute(result, ARGUMENT( 1), behaviour);
-    InternalEval(aEnvironment, RESULT, result);
+    LispPtr evaluated;
+    InternalEval(aEnvironment, evaluated, result);
+    InternalDeepCopy(RESULT, evaluated);
 }
 
 void interpreter(LispEnvironment& aEnvironment, int aStackTop)
@@ -6,6 +6,7 @@
 #include "yacas/patternclass.h"
 #include "yacas/substitute.h"
 
+#include <algorithm>
 #include <memory>
 
 #define InternalEval aEnvironment.iEvaluator->Eval
@@ -45,7 +46,7 @@ LispPtr& BranchingUserFunction::BranchPattern::Body()
 
 
 BranchingUserFunction::BranchingUserFunction(LispPtr& aParameters)
-  : iParameters(),iRules(),iParamList(aParameters)
+  : iParameters(),iRules(),iParamList(aParameters),iVersion(1),iIndex(),iIndexVersion(0),iMemo(),iMemoVersion(0)
 {
   for (LispIterator iter(aParameters); iter.getObj(); ++iter)
   {
@@ -110,25 +111,23 @@ void BranchingUserFunction::Evaluate(LispPtr& aResult,LispEnvironment& aEnvironm
         aEnvironment.NewLocal(variable, arguments[i]);
     }
 
-    // walk the rules database, returning the evaluated result if the
-    // predicate is true.
-    const std::size_t nrRules = iRules.size();
-    UserStackInformation &st = aEnvironment.iEvaluator->StackInformation();
-    for (std::size_t i = 0; i < nrRules; i++) {
-        BranchRuleBase* thisRule = iRules[i];
-        assert(thisRule);
-
-        st.iRulePrecedence = thisRule->Precedence();
-        bool matches = thisRule->Matches(aEnvironment, arguments.get());
-        if (matches) {
-            st.iSide = 1;
-            InternalEval(aEnvironment, aResult, thisRule->Body());
-            goto FINISH;
+    std::size_t hash = 0;
+    if (iMemo) {
+        if (iMemoVersion != iVersion) {
+            iMemo->Clear();
+            iMemoVersion = iVersion;
         }
+        hash = MemoTable::Hash(aEnvironment, arguments.get(), arity);
+        if (iMemo->Find(aEnvironment, hash, arguments.get(), arity, aResult))
+            goto FINISH;
+    }
 
-        // If rules got inserted, walk back
-        while (thisRule != iRules[i] && i > 0)
-            i--;
+    // walk the rules database, returning the evaluated result if the
+    // predicate is true.
+    if (BranchRuleBase* rule = FirstMatch(aEnvironment, arguments.get())) {
+        aEnvironment.iEvaluator->StackInformation().iSide = 1;
+        InternalEval(aEnvironment, aResult, rule->Body());
+        goto REMEMBER;
     }
 
     // No predicate was true: return a new expression with the evaluated
@@ -146,6 +145,11 @@ void BranchingUserFunction::Evaluate(LispPtr& aResult,LispEnvironment& aEnvironm
         aResult = LispSubList::New(full);
     }
 
+REMEMBER:
+    // unless the rules changed meanwhile
+    if (iMemo && iMemoVersion == iVersion)
+        iMemo->Insert(aEnvironment, hash, arguments.get(), arity, aResult);
+
 FINISH:
     if (Traced()) {
         LispPtr tr(LispSubList::New(aArguments));
@@ -154,6 +158,84 @@ FINISH:
     }
 }
 
+BranchingUserFunction::BranchRuleBase*
+BranchingUserFunction::FirstMatch(LispEnvironment& aEnvironment, LispPtr* aArguments) const
+{
+    UserStackInformation &st = aEnvironment.iEvaluator->StackInformation();
+
+    if (iIndexVersion != iVersion)
+        BuildIndex();
+
+    // the positions in iRules of the rules to try, if not all
+    DiscriminationTree::Values candidates;
+    if (iIndex) {
+        candidates.assign(iIndex->iAlways.begin(), iIndex->iAlways.end());
+        iIndex->iTree.Find(aArguments, iParameters.size(), candidates);
+        std::sort(candidates.begin(), candidates.end());
+    }
+
+    const std::size_t version = iVersion;
+    const std::size_t n = iIndex ? candidates.size() : iRules.size();
+
+    for (std::size_t i = 0; i < n; i++) {
+        BranchRuleBase* thisRule = iRules[iIndex ? candidates[i] : i];
+        assert(thisRule);
+
+        st.iRulePrecedence = thisRule->Precedence();
+        if (thisRule->Matches(aEnvironment, aArguments))
+            return thisRule;
+
+        // If rules got inserted, go on with all rules after the one
+        // just tried
+        if (iVersion != version) {
+            std::size_t j = std::find(iRules.begin(), iRules.end(), thisRule) - iRules.begin();
+            for (j += 1; j < iRules.size(); j++) {
+                thisRule = iRules[j];
+                st.iRulePrecedence = thisRule->Precedence();
+                if (thisRule->Matches(aEnvironment, aArguments))
+                    return thisRule;
+
+                while (thisRule != iRules[j] && j > 0)
+                    j--;
+            }
+            return nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+void BranchingUserFunction::BuildIndex() const
+{
+    iIndexVersion = iVersion;
+    iIndex.reset();
+
+    std::unique_ptr<RuleIndex> index(new RuleIndex);
+    bool patterns = false;
+
+    for (std::size_t i = 0; i < iRules.size(); ++i) {
+        const BranchPattern* rule = dynamic_cast<const BranchPattern*>(iRules[i]);
+        if (rule && rule->Pattern().Matcher().ParamMatchers().size() == iParameters.size()) {
+            index->iTree.Add(rule->Pattern().Matcher().ParamMatchers(), i);
+            patterns = true;
+        } else {
+            index->iAlways.push_back(i);
+        }
+    }
+
+    if (patterns)
+        iIndex = std::move(index);
+}
+
+void BranchingUserFunction::Memoize(std::size_t aCapacity)
+{
+    if (aCapacity)
+        iMemo.reset(new MemoTable(aCapacity));
+    else
+        iMemo.reset();
+    iMemoVersion = iVersion;
+}
+
 void BranchingUserFunction::HoldArgument(const LispString * aVariable)
 {
     const std::size_t nrc = iParameters.size();
@@ -258,6 +340,15 @@ void BranchingUserFunction::InsertRule(int aPrecedence,BranchRuleBase* newRule)
     CONTINUE:
     // Insert it
     iRules.insert(iRules.begin() + mid, newRule);
+    iVersion += 1;
+}
+
+void BranchingUserFunction::AppendRule(BranchRuleBase* newRule)
+{
+    assert(iRules.empty() || iRules.back()->Precedence() <= newRule->Precedence());
+
+    iRules.push_back(newRule);
+    iVersion += 1;
 }
 
 const LispPtr& BranchingUserFunction::ArgList() const
@@ -374,30 +465,18 @@ void MacroUserFunction::Evaluate(LispPtr& aResult,LispEnvironment& aEnvironment,
 
         // walk the rules database, returning the evaluated result if the
         // predicate is true.
-        const std::size_t nrRules = iRules.size();
-        UserStackInformation &st = aEnvironment.iEvaluator->StackInformation();
-        for (std::size_t i = 0; i < nrRules; i++) {
-            BranchRuleBase* thisRule = iRules[i];
-            assert(thisRule);
-
-            st.iRulePrecedence = thisRule->Precedence();
-            const bool matches = thisRule->Matches(aEnvironment, arguments.get());
-            if (matches) {
-                st.iSide = 1;
-
-                BackQuoteBehaviour behaviour(aEnvironment);
-                InternalSubstitute(substedBody, thisRule->Body(), behaviour);
-                break;
-            }
+        if (BranchRuleBase* rule = FirstMatch(aEnvironment, arguments.get())) {
+            aEnvironment.iEvaluator->StackInformation().iSide = 1;
 
-            // If rules got inserted, walk back
-            while (thisRule != iRules[i] && i > 0)
-                i--;
+            BackQuoteBehaviour behaviour(aEnvironment);
+            InternalSubstitute(substedBody, rule->Body(), behaviour);
         }
     }
 
     if (!!substedBody) {
-        InternalEval(aEnvironment, aResult, substedBody);
+        LispPtr evaluated;
+        InternalEval(aEnvironment, evaluated, substedBody);
+        InternalDeepCopy(aResult, evaluated);
     } else
         // No predicate was true: return a new expression with the evaluated
         // arguments.
@@ -0,0 +1,86 @@
+#include "yacas/memotable.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/standard.h"
+
+#include <iterator>
+
+static std::size_t Combine(std::size_t aSeed, std::size_t aValue)
+{
+    return aSeed ^ (aValue + 0x9e3779b9 + (aSeed << 6) + (aSeed >> 2));
+}
+
+MemoTable::MemoTable(std::size_t aCapacity):
+    iCapacity(aCapacity),
+    iEntries(),
+    iIndex(),
+    iHits(0),
+    iMisses(0)
+{
+}
+
+std::size_t MemoTable::Hash(LispEnvironment& aEnvironment, LispPtr* aArguments, std::size_t aCount)
+{
+    std::size_t h = Combine(0, aEnvironment.Precision());
+    for (std::size_t i = 0; i < aCount; ++i)
+        h = Combine(h, InternalHash(aEnvironment, aArguments[i]));
+    return h;
+}
+
+bool MemoTable::Find(LispEnvironment& aEnvironment, std::size_t aHash, LispPtr* aArguments, std::size_t aCount, LispPtr& aResult)
+{
+    auto range = iIndex.equal_range(aHash);
+    for (auto i = range.first; i != range.second; ++i) {
+        const Entries::iterator e = i->second;
+
+        if (e->precision != aEnvironment.Precision())
+            continue;
+
+        std::size_t j = 0;
+        while (j < aCount && InternalEquals(aEnvironment, e->arguments[j], aArguments[j]))
+            ++j;
+
+        if (j == aCount) {
+            iEntries.splice(iEntries.begin(), iEntries, e);
+            InternalDeepCopy(aResult, e->result);
+            iHits += 1;
+            return true;
+        }
+    }
+
+    iMisses += 1;
+    return false;
+}
+
+void MemoTable::Insert(LispEnvironment& aEnvironment, std::size_t aHash, LispPtr* aArguments, std::size_t aCount, LispPtr& aResult)
+{
+    if (!iCapacity)
+        return;
+
+    if (iEntries.size() >= iCapacity) {
+        const Entries::iterator last = std::prev(iEntries.end());
+        auto range = iIndex.equal_range(last->hash);
+        for (auto i = range.first; i != range.second; ++i) {
+            if (i->second == last) {
+                iIndex.erase(i);
+                break;
+            }
+        }
+        iEntries.erase(last);
+    }
+
+    std::vector<LispPtr> arguments(aCount);
+    for (std::size_t i = 0; i < aCount; ++i)
+        InternalDeepCopy(arguments[i], aArguments[i]);
+
+    LispPtr result;
+    InternalDeepCopy(result, aResult);
+
+    iEntries.push_front(Entry{aHash, aEnvironment.Precision(), std::move(arguments), result});
+    iIndex.insert(std::make_pair(aHash, iEntries.begin()));
+}
+
+void MemoTable::Clear()
+{
+    iIndex.clear();
+    iEntries.clear();
+}
@@ -0,0 +1,342 @@
+#include "yacas/packedarrayclass.h"
+#include "yacas/lispatom.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/lisperror.h"
+#include "yacas/numbers.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+static void IntegerOutOfRange()
+{
+    throw LispErrGeneric("PackedArray: integer result out of range");
+}
+
+static void FloatOutOfRange()
+{
+    throw LispErrGeneric("PackedArray: float result out of range");
+}
+
+// The shortest decimal which reads back as aValue, written as a float
+// even when it is whole, since BigNumber::SetTo(double) loses whole
+// values and prints digits beyond the precision of a double
+static LispObject* FloatNumber(LispEnvironment& aEnvironment, double aValue)
+{
+    if (!std::isfinite(aValue))
+        FloatOutOfRange();
+
+    std::string digits;
+    for (int precision = 15; precision <= 17; ++precision) {
+        std::ostringstream buf;
+        buf << std::setprecision(precision) << aValue;
+        digits = buf.str();
+        if (std::strtod(digits.c_str(), nullptr) == aValue)
+            break;
+    }
+
+    if (digits.find_first_of(".e") == std::string::npos)
+        digits += ".";
+
+    return new LispNumber(new LispString(digits), aEnvironment.Precision());
+}
+
+// Whether aObject is an integer which fits in an integer array, and if
+// so its value. Literals of more than 18 digits aren't held as small
+// integers, so those are read from their BigNumber.
+static bool PackableInteger(LispEnvironment& aEnvironment, LispObject* aObject, std::int64_t& aValue)
+{
+    if (!aObject->SmallInteger(aValue)) {
+        BigNumber* n = aObject->Number(aEnvironment.Precision());
+        if (!n || !n->IsInt() || n->BitCount() >= 64)
+            return false;
+
+        LispString digits;
+        n->ToString(digits, aEnvironment.Precision());
+        aValue = std::strtoll(digits.c_str(), nullptr, 10);
+    }
+
+    return aValue > -PackedArrayClass::IntegerLimit && aValue < PackedArrayClass::IntegerLimit;
+}
+
+bool PackedArrayClass::Packable(LispEnvironment& aEnvironment, LispObject* aList, Type& aType)
+{
+    LispPtr* list = aList->SubList();
+    if (!list || !*list || (*list)->String() != aEnvironment.iList->String())
+        return false;
+
+    aType = Integer;
+    for (LispObject* p = (*list)->Nixed(); p; p = p->Nixed()) {
+        std::int64_t i;
+        if (PackableInteger(aEnvironment, p, i))
+            continue;
+        if (!p->Number(aEnvironment.Precision()))
+            return false;
+        aType = Float;
+    }
+
+    return true;
+}
+
+PackedArrayClass* PackedArrayClass::FromList(LispEnvironment& aEnvironment, LispObject* aList)
+{
+    Type type;
+    if (!Packable(aEnvironment, aList, type))
+        throw LispErrInvalidArg();
+
+    LispObject* first = (*aList->SubList())->Nixed();
+
+    if (type == Integer) {
+        std::vector<std::int64_t> integers;
+        for (LispObject* p = first; p; p = p->Nixed()) {
+            std::int64_t i;
+            PackableInteger(aEnvironment, p, i);
+            integers.push_back(i);
+        }
+        return new PackedArrayClass(std::move(integers));
+    }
+
+    std::vector<double> floats;
+    for (LispObject* p = first; p; p = p->Nixed()) {
+        std::int64_t i;
+        if (p->SmallInteger(i))
+            floats.push_back(static_cast<double>(i));
+        else
+            floats.push_back(p->Number(aEnvironment.Precision())->Double());
+        if (!std::isfinite(floats.back()))
+            throw LispErrInvalidArg();
+    }
+    return new PackedArrayClass(std::move(floats));
+}
+
+LispObject* PackedArrayClass::GetElement(LispEnvironment& aEnvironment, std::size_t aItem) const
+{
+    assert(aItem > 0 && aItem <= Size());
+
+    if (iType == Integer)
+        return new LispNumber(iIntegers[aItem - 1], 0, aEnvironment.Precision());
+
+    return FloatNumber(aEnvironment, iFloats[aItem - 1]);
+}
+
+LispPtr PackedArrayClass::ToList(LispEnvironment& aEnvironment) const
+{
+    LispPtr head(aEnvironment.iList->Copy());
+    LispPtr* tail = &head->Nixed();
+    for (std::size_t i = 1; i <= Size(); ++i) {
+        *tail = GetElement(aEnvironment, i);
+        tail = &(*tail)->Nixed();
+    }
+    return LispPtr(LispSubList::New(head));
+}
+
+PackedArrayClass* PackedArrayClass::Fill(LispEnvironment& aEnvironment, LispObject* aNumber, std::size_t aSize)
+{
+    std::int64_t i;
+    if (PackableInteger(aEnvironment, aNumber, i))
+        return new PackedArrayClass(std::vector<std::int64_t>(aSize, i));
+
+    BigNumber* n = aNumber->Number(aEnvironment.Precision());
+    if (n && std::isfinite(n->Double()))
+        return new PackedArrayClass(std::vector<double>(aSize, n->Double()));
+
+    return nullptr;
+}
+
+std::vector<double> PackedArrayClass::AsFloats() const
+{
+    if (iType == Float)
+        return iFloats;
+
+    return std::vector<double>(iIntegers.begin(), iIntegers.end());
+}
+
+PackedArrayClass* PackedArrayClass::Elementwise(Operation aOperation, const PackedArrayClass& aX, const PackedArrayClass& aY)
+{
+    assert(aX.Size() == aY.Size());
+
+    const std::size_t n = aX.Size();
+
+    if (aX.iType == Integer && aY.iType == Integer && aOperation != Divide) {
+        const std::int64_t* x = aX.iIntegers.data();
+        const std::int64_t* y = aY.iIntegers.data();
+        std::vector<std::int64_t> result(n);
+        std::int64_t* r = result.data();
+
+        // sums and differences of integers below the limit fit in a
+        // machine word, and only need checking against the limit
+        bool out = false;
+        switch (aOperation) {
+        case Add:
+            for (std::size_t i = 0; i < n; ++i) {
+                r[i] = x[i] + y[i];
+                out |= (r[i] >= IntegerLimit) | (r[i] <= -IntegerLimit);
+            }
+            break;
+        case Subtract:
+            for (std::size_t i = 0; i < n; ++i) {
+                r[i] = x[i] - y[i];
+                out |= (r[i] >= IntegerLimit) | (r[i] <= -IntegerLimit);
+            }
+            break;
+        default:
+            // products may wrap, which the estimate in floating point
+            // catches, with a margin for its rounding; the suspects are
+            // checked exactly, |x*y| < IntegerLimit being the same as
+            // |y| <= (IntegerLimit - 1) / |x| in integer division
+            for (std::size_t i = 0; i < n; ++i) {
+                r[i] = static_cast<std::int64_t>(static_cast<std::uint64_t>(x[i]) * static_cast<std::uint64_t>(y[i]));
+                out |= std::fabs(static_cast<double>(x[i]) * static_cast<double>(y[i])) >= 4.0e18;
+            }
+            if (out) {
+                for (std::size_t i = 0; i < n; ++i)
+                    if (x[i] != 0 && std::abs(y[i]) > (IntegerLimit - 1) / std::abs(x[i]))
+                        IntegerOutOfRange();
+                out = false;
+            }
+            break;
+        }
+
+        if (out)
+            IntegerOutOfRange();
+
+        return new PackedArrayClass(std::move(result));
+    }
+
+    std::vector<double> result(aX.AsFloats());
+    const std::vector<double> other(aY.AsFloats());
+    double* r = result.data();
+    const double* y = other.data();
+
+    switch (aOperation) {
+    case Add:
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] += y[i];
+        break;
+    case Subtract:
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] -= y[i];
+        break;
+    case Multiply:
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] *= y[i];
+        break;
+    case Divide: {
+        bool zero = false;
+        for (std::size_t i = 0; i < n; ++i)
+            zero |= (y[i] == 0);
+        if (zero)
+            throw LispErrDivideByZero();
+        for (std::size_t i = 0; i < n; ++i)
+            r[i] /= y[i];
+        break;
+    }
+    }
+
+    bool out = false;
+    for (std::size_t i = 0; i < n; ++i)
+        out |= !std::isfinite(r[i]);
+    if (out)
+        FloatOutOfRange();
+
+    return new PackedArrayClass(std::move(result));
+}
+
+// The sum of aCount integers below the limit. The high and low parts of
+// the values are summed apart, which does not overflow before there are
+// 2^32 of them, and the parts are only combined in a BigNumber if the
+// sum does not fit.
+static LispObject* IntegerSum(LispEnvironment& aEnvironment, const std::int64_t* aValues, std::size_t aCount)
+{
+    std::int64_t high = 0;
+    std::int64_t low = 0;
+    for (std::size_t i = 0; i < aCount; ++i) {
+        high += aValues[i] >> 31;
+        low += aValues[i] & 0x7fffffff;
+    }
+    high += low >> 31;
+    low &= 0x7fffffff;
+
+    if (high > -(std::int64_t(1) << 30) && high < (std::int64_t(1) << 30))
+        return new LispNumber(high * (std::int64_t(1) << 31) + low, 0, aEnvironment.Precision());
+
+    const int precision = aEnvironment.BinaryPrecision();
+    BigNumber h, shift, l, product;
+    h.SetTo(high, 0, aEnvironment.Precision());
+    shift.SetTo(std::int64_t(1) << 31, 0, aEnvironment.Precision());
+    l.SetTo(low, 0, aEnvironment.Precision());
+    product.Multiply(h, shift, precision);
+    BigNumber* z = new BigNumber(precision);
+    z->Add(product, l, precision);
+    return new LispNumber(z);
+}
+
+// Four partial sums, which the compiler can keep in vector registers
+// without reordering a single sum
+static double FloatSum(const double* aValues, std::size_t aCount)
+{
+    double s[4] = { 0, 0, 0, 0 };
+    std::size_t i = 0;
+    for (; i + 4 <= aCount; i += 4)
+        for (int j = 0; j < 4; ++j)
+            s[j] += aValues[i + j];
+    for (; i < aCount; ++i)
+        s[0] += aValues[i];
+    return (s[0] + s[1]) + (s[2] + s[3]);
+}
+
+LispObject* PackedArrayClass::Sum(LispEnvironment& aEnvironment) const
+{
+    if (iType == Integer)
+        return IntegerSum(aEnvironment, iIntegers.data(), iIntegers.size());
+
+    return FloatNumber(aEnvironment, FloatSum(iFloats.data(), iFloats.size()));
+}
+
+LispObject* PackedArrayClass::Dot(LispEnvironment& aEnvironment, const PackedArrayClass& aOther) const
+{
+    assert(Size() == aOther.Size());
+
+    const std::size_t n = Size();
+
+    if (iType == Integer && aOther.iType == Integer) {
+        const std::int64_t* x = iIntegers.data();
+        const std::int64_t* y = aOther.iIntegers.data();
+
+        // products of integers of 31 bits are below the limit
+        const std::int64_t small = std::int64_t(1) << 31;
+        bool large = false;
+        for (std::size_t i = 0; i < n; ++i)
+            large |= (x[i] <= -small) | (x[i] >= small) | (y[i] <= -small) | (y[i] >= small);
+
+        if (!large) {
+            std::vector<std::int64_t> products(n);
+            for (std::size_t i = 0; i < n; ++i)
+                products[i] = x[i] * y[i];
+            return IntegerSum(aEnvironment, products.data(), n);
+        }
+
+        const int precision = aEnvironment.BinaryPrecision();
+        RefPtr<BigNumber> sum(new BigNumber(precision));
+        sum->SetTo(std::int64_t(0), 0, aEnvironment.Precision());
+        for (std::size_t i = 0; i < n; ++i) {
+            BigNumber a, b, product;
+            a.SetTo(x[i], 0, aEnvironment.Precision());
+            b.SetTo(y[i], 0, aEnvironment.Precision());
+            product.Multiply(a, b, precision);
+            RefPtr<BigNumber> next(new BigNumber(precision));
+            next->Add(*sum, product, precision);
+            sum = next;
+        }
+        return new LispNumber(sum.ptr());
+    }
+
+    const std::vector<double> x(AsFloats());
+    const std::vector<double> y(aOther.AsFloats());
+    std::vector<double> products(n);
+    for (std::size_t i = 0; i < n; ++i)
+        products[i] = x[i] * y[i];
+    return FloatNumber(aEnvironment, FloatSum(products.data(), n));
+}
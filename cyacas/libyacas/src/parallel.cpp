@@ -0,0 +1,505 @@
+#include "yacas/parallel.h"
+
+#include "yacas/lispatom.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/lisperror.h"
+#include "yacas/lispeval.h"
+#include "yacas/snapshot.h"
+#include "yacas/standard.h"
+#include "yacas/yacas.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The clones an environment keeps from one ParallelMap to the next, as
+// long as its definitions don't change. Global variables change more
+// often, and are copied into the clones again instead: whenever those
+// of the environment may have changed they are encoded anew, and a
+// clone whose globals are not the latest ones, or may have been changed
+// by the function, takes them over before it is used. A clone is used
+// by one worker at a time, and is dropped if the function changed its
+// definitions. The clones are destroyed outside any arena scope, as
+// their objects belong to arenas of their own.
+class ParallelClones: NonCopyable {
+public:
+    ParallelClones();
+    ~ParallelClones();
+
+    /// Make the clones to come from the definitions and globals of
+    /// aEnvironment now, dropping those made from other definitions, and
+    /// have room for aCount of them
+    void Update(LispEnvironment& aEnvironment, std::size_t aCount);
+    void Clear();
+
+    /// Give the environment of aClone the latest globals, if it may not
+    /// have them
+    void SyncGlobals(std::size_t aClone);
+
+    struct Global {
+        std::string name;
+        bool lazy;
+        std::string value;
+    };
+
+    struct Clone {
+        std::unique_ptr<DefaultYacasEnvironment> environment;
+        // the version of the globals it took over, and its globals
+        // generation right after
+        std::uint64_t version;
+        std::uint64_t generation;
+    };
+
+    // the snapshot the clones are loaded from, what it was made of, and
+    // the version of the globals in it
+    std::string iSnapshot;
+    std::uint64_t iGeneration;
+    int iPrecision;
+    std::vector<std::string> iInputDirectories;
+    std::uint64_t iSnapshotVersion;
+
+    // the globals of the environment in their latest version, encoded in
+    // its globals generation
+    std::vector<Global> iGlobals;
+    std::uint64_t iGlobalsGeneration;
+    std::uint64_t iVersion;
+
+    std::vector<Clone> iClones;
+    // whether a ParallelMap is using the clones
+    bool iBusy;
+    // where the side effects go
+    std::ostream iDiscarded;
+};
+
+ParallelClones::ParallelClones():
+    iGeneration(0),
+    iPrecision(0),
+    iSnapshotVersion(0),
+    iGlobalsGeneration(0),
+    iVersion(0),
+    iBusy(false),
+    iDiscarded(nullptr)
+{
+}
+
+ParallelClones::~ParallelClones()
+{
+    Clear();
+}
+
+void ParallelClones::Update(LispEnvironment& aEnvironment, std::size_t aCount)
+{
+    if (iGlobalsGeneration != aEnvironment.GlobalsGeneration()) {
+        iGlobals.clear();
+        for (const LispGlobal::value_type& g: aEnvironment.Globals()) {
+            const Global global = {*g.first, g.second.iEvalBeforeReturn, SaveExpression(g.second.iValue)};
+            iGlobals.push_back(global);
+        }
+
+        iGlobalsGeneration = aEnvironment.GlobalsGeneration();
+        iVersion += 1;
+    }
+
+    if (iGeneration != aEnvironment.DefinitionsGeneration() ||
+        iPrecision != aEnvironment.Precision() ||
+        iInputDirectories != aEnvironment.iInputDirectories) {
+        Clear();
+
+        std::ostringstream snapshot;
+        SaveSnapshot(aEnvironment, snapshot, true);
+        iSnapshot = snapshot.str();
+
+        iGeneration = aEnvironment.DefinitionsGeneration();
+        iPrecision = aEnvironment.Precision();
+        iInputDirectories = aEnvironment.iInputDirectories;
+        iSnapshotVersion = iVersion;
+    }
+
+    if (iClones.size() < aCount)
+        iClones.resize(aCount);
+}
+
+void ParallelClones::Clear()
+{
+    Arena::Scope scope(nullptr);
+    iClones.clear();
+}
+
+void ParallelClones::SyncGlobals(std::size_t aClone)
+{
+    Clone& clone = iClones[aClone];
+    LispEnvironment& env = clone.environment->getEnv();
+
+    if (clone.version == iVersion && clone.generation == env.GlobalsGeneration())
+        return;
+
+    std::vector<const LispString*> names;
+    for (const Global& global: iGlobals)
+        names.push_back(env.HashTable().LookUp(global.name));
+
+    std::vector<LispStringSmartPtr> unset;
+    for (const LispGlobal::value_type& g: env.Globals())
+        if (std::find(names.begin(), names.end(), g.first) == names.end())
+            unset.push_back(g.first);
+    for (const LispStringSmartPtr& name: unset)
+        env.UnsetVariable(name);
+
+    for (std::size_t i = 0; i < iGlobals.size(); ++i) {
+        LispPtr value(LoadExpression(env, iGlobals[i].value));
+
+        // some symbols are protected by the environment itself
+        const bool protect = env.Protected(names[i]);
+        env.UnProtect(names[i]);
+        env.SetVariable(names[i], value, iGlobals[i].lazy);
+        if (protect)
+            env.Protect(names[i]);
+    }
+
+    clone.version = iVersion;
+    clone.generation = env.GlobalsGeneration();
+}
+
+namespace {
+
+// (Hold aObject)
+LispPtr Held(LispEnvironment& aEnvironment, LispObject* aObject)
+{
+    LispPtr hold(LispAtom::New(aEnvironment, "Hold"));
+    hold->Nixed() = aObject->Copy();
+    return LispPtr(LispSubList::New(hold));
+}
+
+// Apply aFunction to aElement, as MapSingle does, so that neither is
+// evaluated again
+void Apply(LispEnvironment& aEnvironment, LispObject* aFunction, LispObject* aElement, LispPtr& aResult)
+{
+    LispPtr arguments(aEnvironment.iList->Copy());
+    arguments->Nixed() = Held(aEnvironment, aElement);
+
+    LispPtr apply(LispAtom::New(aEnvironment, "Apply"));
+    apply->Nixed() = Held(aEnvironment, aFunction);
+    apply->Nixed()->Nixed() = LispSubList::New(arguments);
+
+    LispPtr expression(LispSubList::New(apply));
+    aEnvironment.iEvaluator->Eval(aEnvironment, aResult, expression);
+}
+
+std::vector<LispObject*> Elements(LispObject* aList)
+{
+    std::vector<LispObject*> elements;
+    for (LispObject* p = (*aList->SubList())->Nixed(); p; p = p->Nixed())
+        elements.push_back(p);
+    return elements;
+}
+
+class Pool {
+public:
+    Pool(LispEnvironment& aEnvironment, LispObject* aFunction, LispObject* aList, std::size_t aWorkers);
+    ~Pool();
+
+    LispPtr Run();
+
+private:
+    // The elements not yet taken by a worker
+    struct Share {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    bool Next(std::size_t aWorker, std::size_t& aIndex);
+    void Work(std::size_t aWorker);
+    void Fail(const std::string& aError);
+    void Stop();
+
+    LispEnvironment& iEnvironment;
+    LispObject* const iFunction;
+    const std::vector<LispObject*> iElements;
+
+    // the clones of the environment, or those of the pool itself if the
+    // function calls ParallelMap while the others are in use
+    ParallelClones* iClones;
+    std::unique_ptr<ParallelClones> iOwnClones;
+
+    std::string iEncodedFunction;
+    std::string iEncodedList;
+
+    std::vector<Share> iShares;
+    // the results of the calling environment, and of the others
+    std::vector<LispPtr> iResults;
+    std::vector<std::string> iEncodedResults;
+
+    std::vector<std::thread> iThreads;
+
+    std::mutex iMutex;
+    std::condition_variable iDone;
+    std::size_t iRunning;
+    // the environments of the other workers while they evaluate, so
+    // that they can be stopped
+    std::vector<LispEnvironment*> iWorkers;
+    std::atomic<bool> iStop;
+    std::string iError;
+};
+
+Pool::Pool(LispEnvironment& aEnvironment, LispObject* aFunction, LispObject* aList, std::size_t aWorkers):
+    iEnvironment(aEnvironment),
+    iFunction(aFunction),
+    iElements(Elements(aList)),
+    iShares(aWorkers),
+    iResults(iElements.size()),
+    iEncodedResults(iElements.size()),
+    iRunning(0),
+    iWorkers(aWorkers, nullptr),
+    iStop(false)
+{
+    if (!aEnvironment.iParallelClones)
+        aEnvironment.iParallelClones = std::make_shared<ParallelClones>();
+
+    iClones = aEnvironment.iParallelClones.get();
+    if (iClones->iBusy) {
+        iOwnClones.reset(new ParallelClones);
+        iClones = iOwnClones.get();
+    }
+
+    iClones->Update(aEnvironment, aWorkers - 1);
+
+    iEncodedFunction = SaveExpression(aFunction);
+    iEncodedList = SaveExpression(aList);
+
+    for (std::size_t i = 0; i < aWorkers; ++i) {
+        iShares[i].begin = iElements.size() * i / aWorkers;
+        iShares[i].end = iElements.size() * (i + 1) / aWorkers;
+    }
+
+    iClones->iBusy = true;
+}
+
+Pool::~Pool()
+{
+    Stop();
+
+    for (std::thread& thread: iThreads)
+        thread.join();
+
+    iClones->iBusy = false;
+}
+
+bool Pool::Next(std::size_t aWorker, std::size_t& aIndex)
+{
+    if (iStop)
+        return false;
+
+    Share& own = iShares[aWorker];
+
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin < own.end) {
+            aIndex = own.begin++;
+            return true;
+        }
+    }
+
+    // take the upper half of what is left of another share
+    for (std::size_t k = 1; k < iShares.size(); ++k) {
+        Share& victim = iShares[(aWorker + k) % iShares.size()];
+
+        std::size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            const std::size_t left = victim.end - victim.begin;
+            if (left == 0)
+                continue;
+            begin = victim.end - (left + 1) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin + 1;
+        own.end = end;
+        aIndex = begin;
+        return true;
+    }
+
+    return false;
+}
+
+void Pool::Work(std::size_t aWorker)
+{
+    ParallelClones::Clone& clone = iClones->iClones[aWorker - 1];
+    bool keep = false;
+
+    try {
+        const bool fresh = !clone.environment;
+        if (fresh)
+            clone.environment.reset(new DefaultYacasEnvironment(iClones->iDiscarded));
+
+        Arena::Scope scope(&clone.environment->getArena());
+
+        LispEnvironment& env = clone.environment->getEnv();
+
+        if (fresh) {
+            env.iInputDirectories = iEnvironment.iInputDirectories;
+
+            // the files were checked when the caller read them
+            std::istringstream snapshot(iClones->iSnapshot);
+            if (!LoadSnapshot(env, snapshot, true))
+                throw LispErrGeneric("ParallelMap: cannot clone the environment");
+
+            clone.version = iClones->iSnapshotVersion;
+            clone.generation = env.GlobalsGeneration();
+        }
+
+        iClones->SyncGlobals(aWorker - 1);
+
+        const std::uint64_t generation = env.DefinitionsGeneration();
+        const int precision = env.Precision();
+
+        env.iBudget = iEnvironment.iBudget;
+        env.StartBudget();
+
+        // registered while the environment exists, even if evaluating
+        // throws
+        struct Registration {
+            Registration(Pool& aPool, std::size_t aWorker, LispEnvironment& aEnvironment):
+                pool(aPool), worker(aWorker)
+            {
+                std::lock_guard<std::mutex> lock(pool.iMutex);
+                pool.iWorkers[worker] = &aEnvironment;
+                aEnvironment.stop_evaluation = pool.iStop.load();
+            }
+
+            ~Registration()
+            {
+                std::lock_guard<std::mutex> lock(pool.iMutex);
+                pool.iWorkers[worker] = nullptr;
+            }
+
+            Pool& pool;
+            std::size_t worker;
+        } registration(*this, aWorker, env);
+
+        LispPtr function(LoadExpression(env, iEncodedFunction));
+        LispPtr list(LoadExpression(env, iEncodedList));
+        const std::vector<LispObject*> elements = Elements(list);
+
+        std::size_t i;
+        while (Next(aWorker, i)) {
+            LispPtr result;
+            Apply(env, function, elements[i], result);
+            iEncodedResults[i] = SaveExpression(result);
+        }
+
+        keep = !iStop && env.DefinitionsGeneration() == generation && env.Precision() == precision;
+    } catch (const LispError& error) {
+        Fail(error.what());
+    } catch (const std::exception& error) {
+        Fail(std::string("ParallelMap: ") + error.what());
+    } catch (...) {
+        Fail("ParallelMap: unknown error");
+    }
+
+    // outside the scope of its arena
+    if (!keep)
+        clone.environment.reset();
+
+    std::lock_guard<std::mutex> lock(iMutex);
+    iRunning -= 1;
+    iDone.notify_all();
+}
+
+void Pool::Fail(const std::string& aError)
+{
+    {
+        std::lock_guard<std::mutex> lock(iMutex);
+        if (iError.empty())
+            iError = aError;
+    }
+
+    Stop();
+}
+
+void Pool::Stop()
+{
+    std::lock_guard<std::mutex> lock(iMutex);
+    iStop = true;
+    for (LispEnvironment* worker: iWorkers)
+        if (worker)
+            worker->stop_evaluation = true;
+}
+
+LispPtr Pool::Run()
+{
+    iRunning = iShares.size() - 1;
+    for (std::size_t i = 1; i < iShares.size(); ++i)
+        iThreads.emplace_back(&Pool::Work, this, i);
+
+    // the calling environment is the first worker; an error it runs
+    // into stops the others as the pool is destroyed
+    std::size_t i;
+    while (Next(0, i))
+        Apply(iEnvironment, iFunction, iElements[i], iResults[i]);
+
+    // the calling environment can still be interrupted, or run out of
+    // its budget, while it waits for the others
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(iMutex);
+            if (iDone.wait_for(lock, std::chrono::milliseconds(10), [this] { return iRunning == 0; }))
+                break;
+        }
+
+        if (iEnvironment.stop_evaluation) {
+            iEnvironment.stop_evaluation = false;
+            throw LispErrUserInterrupt();
+        }
+
+        iEnvironment.CheckBudget();
+    }
+
+    if (!iError.empty())
+        throw LispErrGeneric(iError);
+
+    LispPtr results(iEnvironment.iList->Copy());
+    LispPtr* tail = &results->Nixed();
+    for (std::size_t i = 0; i < iElements.size(); ++i) {
+        *tail = !!iResults[i] ? iResults[i] : LoadExpression(iEnvironment, iEncodedResults[i]);
+        tail = &(*tail)->Nixed();
+    }
+
+    return LispPtr(LispSubList::New(results));
+}
+
+}
+
+LispPtr ParallelMap(LispEnvironment& aEnvironment, LispObject* aFunction, LispObject* aList, std::size_t aWorkers)
+{
+    const std::vector<LispObject*> elements = Elements(aList);
+
+    if (aWorkers == 0)
+        aWorkers = std::thread::hardware_concurrency();
+    if (aWorkers > elements.size())
+        aWorkers = elements.size();
+
+    if (aWorkers <= 1) {
+        LispPtr results(aEnvironment.iList->Copy());
+        LispPtr* tail = &results->Nixed();
+        for (LispObject* element: elements) {
+            Apply(aEnvironment, aFunction, element, *tail);
+            tail = &(*tail)->Nixed();
+        }
+        return LispPtr(LispSubList::New(results));
+    }
+
+    Pool pool(aEnvironment, aFunction, aList, aWorkers);
+    return pool.Run();
+}
@@ -5,6 +5,7 @@
 #include "yacas/lispeval.h"
 #include "yacas/standard.h"
 
+#include <algorithm>
 #include <memory>
 
 bool MatchAtom::ArgumentMatches(LispEnvironment& aEnvironment,
@@ -168,7 +169,9 @@ const YacasParamMatcherBase* YacasPatternPredicateBase::MakeParamMatcher(LispEnv
 YacasPatternPredicateBase::YacasPatternPredicateBase(
     LispEnvironment& aEnvironment,
     LispPtr& aPattern,
-    LispPtr& aPostPredicate)
+    LispPtr& aPostPredicate):
+    iPattern(aPattern),
+    iPostPredicate(aPostPredicate)
 {
     for (LispIterator iter(aPattern); iter.getObj(); ++iter) {
         const YacasParamMatcherBase* matcher = MakeParamMatcher(aEnvironment, iter.getObj());
@@ -176,13 +179,43 @@ YacasPatternPredicateBase::YacasPatternPredicateBase(
         iParamMatchers.push_back(matcher);
     }
 
-    iPredicates.push_back(aPostPredicate);
+    // most rules have no postpredicate, which makes it True
+    if (!IsTrue(aEnvironment, aPostPredicate))
+        iPredicates.push_back(aPostPredicate);
 }
 
+// The values of the pattern variables of one match, on top of
+// LispEnvironment::iPatternBindings. They start out empty, and are
+// released when the match is done.
+class PatternBindings: NonCopyable {
+public:
+    PatternBindings(LispEnvironment& aEnvironment, std::size_t aCount):
+        iBindings(aEnvironment.iPatternBindings),
+        iBase(iBindings.size())
+    {
+        iBindings.resize(iBase + aCount);
+    }
+
+    ~PatternBindings()
+    {
+        iBindings.resize(iBase);
+    }
+
+    /// Valid until another match starts
+    LispPtr* get()
+    {
+        return iBindings.data() + iBase;
+    }
+
+private:
+    std::vector<LispPtr>& iBindings;
+    const std::size_t iBase;
+};
+
 bool YacasPatternPredicateBase::Matches(LispEnvironment& aEnvironment,
                                               LispPtr& aArguments)
 {
-    std::unique_ptr<LispPtr[]> arguments(iVariables.empty() ? nullptr : new LispPtr[iVariables.size()]);
+    PatternBindings bindings(aEnvironment, iVariables.size());
 
     LispIterator iter(aArguments);
     const std::size_t n = iParamMatchers.size();
@@ -192,28 +225,14 @@ bool YacasPatternPredicateBase::Matches(LispEnvironment& aEnvironment,
         if (!iter.getObj())
             return false;
         
-        if (!iParamMatchers[i]->ArgumentMatches(aEnvironment, *iter, arguments.get()))
+        if (!iParamMatchers[i]->ArgumentMatches(aEnvironment, *iter, bindings.get()))
             return false;
     }
     
     if (iter.getObj())
         return false;
 
-    {
-        // set the local variables.
-        LispLocalFrame frame(aEnvironment,false);
-
-        SetPatternVariables(aEnvironment, arguments.get());
-
-        // do the predicates
-        if (!CheckPredicates(aEnvironment))
-            return false;
-    }
-
-    // set the local variables for sure now
-    SetPatternVariables(aEnvironment, arguments.get());
-
-    return true;
+    return SetIfPredicatesHold(aEnvironment);
 }
 
 
@@ -222,25 +241,42 @@ bool YacasPatternPredicateBase::Matches(LispEnvironment& aEnvironment,
 bool YacasPatternPredicateBase::Matches(LispEnvironment& aEnvironment,
                                               LispPtr* aArguments)
 {
-    std::unique_ptr<LispPtr[]> arguments(iVariables.empty() ? nullptr : new LispPtr[iVariables.size()]);
+    PatternBindings bindings(aEnvironment, iVariables.size());
 
     const std::size_t n = iParamMatchers.size();
     for (std::size_t i = 0; i < n; ++i)
-        if (!iParamMatchers[i]->ArgumentMatches(aEnvironment,aArguments[i],arguments.get()))
+        if (!iParamMatchers[i]->ArgumentMatches(aEnvironment,aArguments[i],bindings.get()))
             return false;
 
-    {
-        // set the local variables.
-        LispLocalFrame frame(aEnvironment, false);
-        SetPatternVariables(aEnvironment, arguments.get());
+    return SetIfPredicatesHold(aEnvironment);
+}
 
-        // do the predicates
-        if (!CheckPredicates(aEnvironment))
-            return false;
+bool YacasPatternPredicateBase::SetIfPredicatesHold(LispEnvironment& aEnvironment)
+{
+    const std::size_t n = iVariables.size();
+
+    // evaluating the predicates may start other matches, which may move
+    // the bindings, so they are looked up again afterwards
+    LispPtr* arguments = aEnvironment.iPatternBindings.data() + aEnvironment.iPatternBindings.size() - n;
+
+    if (iPredicates.empty()) {
+        SetPatternVariables(aEnvironment, arguments);
+        return true;
     }
 
-    // set the local variables for sure now
-    SetPatternVariables(aEnvironment, arguments.get());
+    // the predicates see the variables in a frame which is kept on success
+    LispLocalFrame frame(aEnvironment, false);
+    SetPatternVariables(aEnvironment, arguments);
+
+    if (!CheckPredicates(aEnvironment))
+        return false;
+
+    frame.Merge(n);
+
+    // undo any changes the predicates made to the variables
+    arguments = aEnvironment.iPatternBindings.data() + aEnvironment.iPatternBindings.size() - n;
+    for (std::size_t i = 0; i < n; ++i)
+        aEnvironment.SetVariable(iVariables[i], arguments[i], false);
 
     return true;
 }
@@ -298,3 +334,99 @@ YacasPatternPredicateBase::~YacasPatternPredicateBase()
     for (const YacasParamMatcherBase* p: iParamMatchers)
         delete p;
 }
+
+DiscriminationTree::DiscriminationTree()
+{
+}
+
+DiscriminationTree::~DiscriminationTree()
+{
+}
+
+DiscriminationTree::Node* DiscriminationTree::Step(Node* aNode, const YacasParamMatcherBase* aMatcher)
+{
+    std::unique_ptr<Node>* next;
+
+    if (const MatchAtom* atom = dynamic_cast<const MatchAtom*>(aMatcher)) {
+        next = &aNode->iAtoms[atom->String()];
+    } else if (dynamic_cast<const MatchNumber*>(aMatcher)) {
+        next = &aNode->iNumber;
+    } else if (const MatchSubList* list = dynamic_cast<const MatchSubList*>(aMatcher)) {
+        const std::size_t length = list->Matchers().size();
+        aNode->iLongestList = std::max(aNode->iLongestList, length);
+        next = &aNode->iLists[length];
+    } else {
+        next = &aNode->iVariable;
+    }
+
+    if (!*next)
+        next->reset(new Node);
+
+    Node* node = next->get();
+
+    if (const MatchSubList* list = dynamic_cast<const MatchSubList*>(aMatcher))
+        for (const YacasParamMatcherBase* m: list->Matchers())
+            node = Step(node, m);
+
+    return node;
+}
+
+void DiscriminationTree::Add(const std::vector<const YacasParamMatcherBase*>& aMatchers, std::size_t aValue)
+{
+    Node* node = &iRoot;
+    for (const YacasParamMatcherBase* m: aMatchers)
+        node = Step(node, m);
+    node->iValues.push_back(aValue);
+}
+
+void DiscriminationTree::Find(LispPtr* aArguments, std::size_t aCount, Values& aValues) const
+{
+    // Finding is not reentrant, as no code is evaluated
+    iPending.clear();
+    for (std::size_t i = aCount; i > 0; --i)
+        iPending.push_back(aArguments[i - 1]);
+
+    Find(&iRoot, iPending, aValues);
+}
+
+void DiscriminationTree::Find(const Node* aNode, std::vector<LispObject*>& aPending, Values& aValues)
+{
+    if (aPending.empty()) {
+        aValues.insert(aValues.end(), aNode->iValues.begin(), aNode->iValues.end());
+        return;
+    }
+
+    LispObject* argument = aPending.back();
+    aPending.pop_back();
+
+    if (aNode->iVariable)
+        Find(aNode->iVariable.get(), aPending, aValues);
+
+    if (LispPtr* list = argument->SubList()) {
+        if (!aNode->iLists.empty()) {
+            const std::size_t pending = aPending.size();
+            for (LispObject* p = *list; p && aPending.size() - pending <= aNode->iLongestList; p = p->Nixed())
+                aPending.push_back(p);
+
+            const std::size_t length = aPending.size() - pending;
+            auto i = aNode->iLists.find(length);
+            if (i != aNode->iLists.end()) {
+                std::reverse(aPending.begin() + pending, aPending.end());
+                Find(i->second.get(), aPending, aValues);
+            }
+            aPending.resize(pending);
+        }
+    } else if (dynamic_cast<LispNumber*>(argument)) {
+        // atoms in patterns are not numbers
+        if (aNode->iNumber)
+            Find(aNode->iNumber.get(), aPending, aValues);
+    } else if (const LispString* name = argument->String()) {
+        if (!aNode->iAtoms.empty()) {
+            auto i = aNode->iAtoms.find(name);
+            if (i != aNode->iAtoms.end())
+                Find(i->second.get(), aPending, aValues);
+        }
+    }
+
+    aPending.push_back(argument);
+}
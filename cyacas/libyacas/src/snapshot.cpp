@@ -0,0 +1,939 @@
+#include "yacas/snapshot.h"
+
+#include "yacas/arrayclass.h"
+#include "yacas/associationclass.h"
+#include "yacas/lispatom.h"
+#include "yacas/lispenvironment.h"
+#include "yacas/lisperror.h"
+#include "yacas/lispeval.h"
+#include "yacas/mathuserfunc.h"
+#include "yacas/packedarrayclass.h"
+#include "yacas/patternclass.h"
+#include "yacas/platfileio.h"
+#include "yacas/standard.h"
+#include "yacas/tokenizer.h"
+
+#include "yacas/yacas_version.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// A snapshot starts with the magic bytes, followed by the format
+// version, the version of yacas, and the size and fingerprint of the
+// rest. The rest holds the names, sizes and fingerprints of the files
+// the definitions were read from, the table of symbols, and then the
+// definitions, with symbols written as indices into the table.
+const char Magic[8] = { 'Y', 'a', 'c', 'a', 's', 'S', 'n', 'p' };
+const std::uint64_t FormatVersion = 4;
+
+// A compiled script has the same header, followed by the size and
+// fingerprint of the source it was compiled from, the operator
+// definitions of the tokens it was parsed from, the table of symbols and
+// the expressions.
+const char CompiledMagic[8] = { 'Y', 'a', 'c', 'a', 's', 'Y', 's', 'c' };
+
+enum ObjectTag {
+    TagNull,
+    TagAtom,
+    TagNumber,
+    TagList,
+    TagPattern,
+    TagArray,
+    TagAssociation,
+    TagShared,
+    TagPackedArray
+};
+
+enum FunctionKind {
+    KindFunction,
+    KindListed,
+    KindMacro,
+    KindListedMacro
+};
+
+enum RuleKind {
+    RuleTruePredicate,
+    RulePredicate,
+    RulePattern
+};
+
+// FNV-1a
+std::uint64_t Fingerprint(const char* aData, std::size_t aSize)
+{
+    std::uint64_t h = 14695981039346656037ULL;
+    for (std::size_t i = 0; i < aSize; ++i) {
+        h ^= static_cast<unsigned char>(aData[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+bool ReadFile(const std::string& aPath, std::string& aContents)
+{
+    std::ifstream file(aPath, std::ios::binary);
+    if (!file)
+        return false;
+
+    aContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+class Writer {
+public:
+    void Unsigned(std::uint64_t aValue)
+    {
+        while (aValue >= 0x80) {
+            iData += static_cast<char>((aValue & 0x7f) | 0x80);
+            aValue >>= 7;
+        }
+        iData += static_cast<char>(aValue);
+    }
+
+    void Signed(std::int64_t aValue)
+    {
+        Unsigned((static_cast<std::uint64_t>(aValue) << 1) ^ static_cast<std::uint64_t>(aValue >> 63));
+    }
+
+    void String(const std::string& aString)
+    {
+        Unsigned(aString.size());
+        iData += aString;
+    }
+
+    void Symbol(const LispString* aSymbol)
+    {
+        if (!aSymbol) {
+            Unsigned(0);
+            return;
+        }
+
+        auto i = iSymbolIndex.find(aSymbol);
+        if (i == iSymbolIndex.end()) {
+            iSymbols.push_back(aSymbol);
+            i = iSymbolIndex.insert(std::make_pair(aSymbol, iSymbols.size())).first;
+        }
+        Unsigned(i->second);
+    }
+
+    void Object(LispObject* aObject);
+    void Chain(LispObject* aFirst);
+    void Function(const LispArityUserFunction& aFunction);
+
+    const std::string& Data() const { return iData; }
+    const std::vector<const LispString*>& Symbols() const { return iSymbols; }
+
+private:
+    void Generic(GenericClass* aGeneric);
+
+    std::string iData;
+    std::unordered_map<const LispString*, std::size_t> iSymbolIndex;
+    std::vector<const LispString*> iSymbols;
+    // generic objects already written, which are shared when read back
+    std::unordered_map<const GenericClass*, std::size_t> iGenerics;
+};
+
+void Writer::Object(LispObject* aObject)
+{
+    if (!aObject) {
+        Unsigned(TagNull);
+    } else if (dynamic_cast<LispNumber*>(aObject)) {
+        Unsigned(TagNumber);
+        String(*aObject->String());
+    } else if (const LispString* string = aObject->String()) {
+        Unsigned(TagAtom);
+        Symbol(string);
+    } else if (LispPtr* list = aObject->SubList()) {
+        Unsigned(TagList);
+        Chain(*list);
+    } else if (GenericClass* generic = aObject->Generic()) {
+        Generic(generic);
+    } else {
+        throw LispErrGeneric("Snapshot'Save: cannot save an object");
+    }
+}
+
+void Writer::Chain(LispObject* aFirst)
+{
+    std::size_t n = 0;
+    for (LispObject* p = aFirst; p; p = p->Nixed())
+        n += 1;
+
+    Unsigned(n);
+    for (LispObject* p = aFirst; p; p = p->Nixed())
+        Object(p);
+}
+
+void Writer::Generic(GenericClass* aGeneric)
+{
+    auto i = iGenerics.find(aGeneric);
+    if (i != iGenerics.end()) {
+        Unsigned(TagShared);
+        Unsigned(i->second);
+        return;
+    }
+
+    if (const PatternClass* pattern = dynamic_cast<const PatternClass*>(aGeneric)) {
+        Unsigned(TagPattern);
+        Chain(pattern->Matcher().Pattern());
+        Object(pattern->Matcher().PostPredicate());
+    } else if (const ArrayClass* array = dynamic_cast<const ArrayClass*>(aGeneric)) {
+        Unsigned(TagArray);
+        Unsigned(array->Size());
+        for (std::size_t j = 1; j <= array->Size(); ++j)
+            Object(array->GetElement(j));
+    } else if (const AssociationClass* association = dynamic_cast<const AssociationClass*>(aGeneric)) {
+        // the backend and the pairs, without the head of the list
+        Unsigned(TagAssociation);
+        Unsigned(association->GetBackend());
+        Unsigned(association->Size());
+        LispPtr pairs(association->ToList());
+        for (LispObject* p = (*pairs->SubList())->Nixed(); p; p = p->Nixed()) {
+            LispObject* key = (*p->SubList())->Nixed();
+            Object(key);
+            Object(key->Nixed());
+        }
+    } else if (const PackedArrayClass* packed = dynamic_cast<const PackedArrayClass*>(aGeneric)) {
+        // the type and the elements, with floats written as their bits
+        Unsigned(TagPackedArray);
+        Unsigned(packed->GetType());
+        Unsigned(packed->Size());
+        if (packed->GetType() == PackedArrayClass::Integer) {
+            for (std::int64_t i: packed->Integers())
+                Signed(i);
+        } else {
+            for (double d: packed->Floats()) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &d, sizeof bits);
+                Unsigned(bits);
+            }
+        }
+    } else {
+        throw LispErrGeneric(std::string("Snapshot'Save: cannot save objects of type ") + aGeneric->TypeName());
+    }
+
+    const std::size_t index = iGenerics.size();
+    iGenerics.insert(std::make_pair(aGeneric, index));
+}
+
+void Writer::Function(const LispArityUserFunction& aFunction)
+{
+    const BranchingUserFunction* function = dynamic_cast<const BranchingUserFunction*>(&aFunction);
+    if (!function)
+        throw LispErrGeneric("Snapshot'Save: cannot save a user function");
+
+    if (dynamic_cast<const ListedMacroUserFunction*>(function))
+        Unsigned(KindListedMacro);
+    else if (dynamic_cast<const MacroUserFunction*>(function))
+        Unsigned(KindMacro);
+    else if (dynamic_cast<const ListedBranchingUserFunction*>(function))
+        Unsigned(KindListed);
+    else
+        Unsigned(KindFunction);
+
+    Unsigned(function->Parameters().size());
+    for (const BranchingUserFunction::BranchParameter& p: function->Parameters()) {
+        Symbol(p.iParameter);
+        Unsigned(p.iHold ? 1 : 0);
+    }
+
+    Unsigned(function->Fenced() ? 1 : 0);
+    Unsigned(function->Traced() ? 1 : 0);
+    Unsigned(function->Memo() ? function->Memo()->Capacity() : 0);
+
+    Unsigned(function->Rules().size());
+    for (BranchingUserFunction::BranchRuleBase* rule: function->Rules()) {
+        if (BranchingUserFunction::BranchPattern* pattern = dynamic_cast<BranchingUserFunction::BranchPattern*>(rule)) {
+            Unsigned(RulePattern);
+            Signed(rule->Precedence());
+            Object(pattern->Predicate());
+        } else if (dynamic_cast<BranchingUserFunction::BranchRuleTruePredicate*>(rule)) {
+            Unsigned(RuleTruePredicate);
+            Signed(rule->Precedence());
+        } else if (BranchingUserFunction::BranchRule* predicate = dynamic_cast<BranchingUserFunction::BranchRule*>(rule)) {
+            Unsigned(RulePredicate);
+            Signed(rule->Precedence());
+            Object(predicate->Predicate());
+        } else {
+            throw LispErrGeneric("Snapshot'Save: cannot save a rule");
+        }
+        Object(rule->Body());
+    }
+}
+
+class Reader {
+public:
+    Reader(LispEnvironment& aEnvironment, const char* aBegin, const char* aEnd):
+        iEnvironment(aEnvironment), iPosition(aBegin), iEnd(aEnd)
+    {
+    }
+
+    std::uint64_t Unsigned()
+    {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0; ; shift += 7) {
+            if (iPosition == iEnd || shift > 63)
+                Invalid();
+            const unsigned char c = *iPosition++;
+            value |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+            if (!(c & 0x80))
+                return value;
+        }
+    }
+
+    std::int64_t Signed()
+    {
+        const std::uint64_t value = Unsigned();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    int Int()
+    {
+        return static_cast<int>(Signed());
+    }
+
+    std::string String()
+    {
+        const std::uint64_t n = Unsigned();
+        if (n > static_cast<std::uint64_t>(iEnd - iPosition))
+            Invalid();
+        const char* p = iPosition;
+        iPosition += n;
+        return std::string(p, n);
+    }
+
+    const LispString* Symbol()
+    {
+        const std::uint64_t i = Unsigned();
+        if (i > iSymbols.size())
+            Invalid();
+        return i ? iSymbols[i - 1] : nullptr;
+    }
+
+    const LispString* Name()
+    {
+        const LispString* symbol = Symbol();
+        if (!symbol)
+            Invalid();
+        return symbol;
+    }
+
+    void Symbols()
+    {
+        const std::uint64_t n = Unsigned();
+        for (std::uint64_t i = 0; i < n; ++i)
+            iSymbols.push_back(iEnvironment.HashTable().LookUp(String()));
+    }
+
+    LispPtr Object();
+    LispPtr Chain();
+    std::unique_ptr<BranchingUserFunction> Function();
+
+    const char* Position() const { return iPosition; }
+    void Skip(std::size_t n) { iPosition += n; }
+    std::size_t Remaining() const { return iEnd - iPosition; }
+
+    [[noreturn]] static void Invalid()
+    {
+        throw LispErrGeneric("Snapshot'Load: invalid snapshot");
+    }
+
+private:
+    LispEnvironment& iEnvironment;
+    const char* iPosition;
+    const char* iEnd;
+    std::vector<LispStringSmartPtr> iSymbols;
+    std::vector<LispPtr> iGenerics;
+};
+
+LispPtr Reader::Object()
+{
+    LispPtr object;
+
+    switch (Unsigned()) {
+    case TagNull:
+        return object;
+    case TagAtom:
+        object = LispAtom::New(iEnvironment, *Name());
+        return object;
+    case TagNumber:
+        object = LispAtom::New(iEnvironment, String());
+        return object;
+    case TagList:
+        object = LispSubList::New(Chain());
+        return object;
+    case TagPattern: {
+        LispPtr pattern(Chain());
+        LispPtr postPredicate(Object());
+        object = LispGenericClass::New(new PatternClass(new YacasPatternPredicateBase(iEnvironment, pattern, postPredicate)));
+        break;
+    }
+    case TagArray: {
+        const std::uint64_t n = Unsigned();
+        if (n > Remaining())
+            Invalid();
+        ArrayClass* array = new ArrayClass(n, nullptr);
+        object = LispGenericClass::New(array);
+        for (std::size_t i = 1; i <= n; ++i)
+            array->SetElement(i, Object());
+        break;
+    }
+    case TagAssociation: {
+        const std::uint64_t backend = Unsigned();
+        if (backend != AssociationClass::Sorted && backend != AssociationClass::Hashed)
+            Invalid();
+        AssociationClass* association = new AssociationClass(iEnvironment, static_cast<AssociationClass::Backend>(backend));
+        object = LispGenericClass::New(association);
+        for (std::uint64_t n = Unsigned(); n > 0; --n) {
+            LispPtr key(Object());
+            LispPtr value(Object());
+            if (!key || !value)
+                Invalid();
+            association->SetElement(key, value);
+        }
+        break;
+    }
+    case TagPackedArray: {
+        const std::uint64_t type = Unsigned();
+        const std::uint64_t n = Unsigned();
+        if (n > Remaining())
+            Invalid();
+        if (type == PackedArrayClass::Integer) {
+            std::vector<std::int64_t> integers(n);
+            for (std::int64_t& i: integers) {
+                i = Signed();
+                if (i <= -PackedArrayClass::IntegerLimit || i >= PackedArrayClass::IntegerLimit)
+                    Invalid();
+            }
+            object = LispGenericClass::New(new PackedArrayClass(std::move(integers)));
+        } else if (type == PackedArrayClass::Float) {
+            std::vector<double> floats(n);
+            for (double& d: floats) {
+                const std::uint64_t bits = Unsigned();
+                std::memcpy(&d, &bits, sizeof d);
+            }
+            object = LispGenericClass::New(new PackedArrayClass(std::move(floats)));
+        } else {
+            Invalid();
+        }
+        break;
+    }
+    case TagShared: {
+        const std::uint64_t i = Unsigned();
+        if (i >= iGenerics.size())
+            Invalid();
+        object = iGenerics[i]->Copy();
+        return object;
+    }
+    default:
+        Invalid();
+    }
+
+    iGenerics.push_back(object);
+    return object;
+}
+
+LispPtr Reader::Chain()
+{
+    LispPtr first;
+    LispPtr* next = &first;
+
+    for (std::uint64_t n = Unsigned(); n > 0; --n) {
+        *next = Object();
+        if (!*next)
+            Invalid();
+        next = &(*next)->Nixed();
+    }
+
+    return first;
+}
+
+std::unique_ptr<BranchingUserFunction> Reader::Function()
+{
+    const std::uint64_t kind = Unsigned();
+
+    LispPtr parameters;
+    LispPtr* next = &parameters;
+    std::vector<const LispString*> held;
+    for (std::uint64_t n = Unsigned(); n > 0; --n) {
+        const LispString* parameter = Name();
+        *next = LispAtom::New(iEnvironment, *parameter);
+        next = &(*next)->Nixed();
+        if (Unsigned())
+            held.push_back(parameter);
+    }
+
+    std::unique_ptr<BranchingUserFunction> function;
+    switch (kind) {
+    case KindFunction:
+        function.reset(new BranchingUserFunction(parameters));
+        break;
+    case KindListed:
+        function.reset(new ListedBranchingUserFunction(parameters));
+        break;
+    case KindMacro:
+        function.reset(new MacroUserFunction(parameters));
+        break;
+    case KindListedMacro:
+        function.reset(new ListedMacroUserFunction(parameters));
+        break;
+    default:
+        Invalid();
+    }
+
+    for (const LispString* parameter: held)
+        function->HoldArgument(parameter);
+
+    if (!Unsigned())
+        function->UnFence();
+    if (Unsigned())
+        function->Trace();
+    const std::uint64_t memo = Unsigned();
+
+    for (std::uint64_t n = Unsigned(); n > 0; --n) {
+        const std::uint64_t ruleKind = Unsigned();
+        const int precedence = Int();
+
+        if (!function->Rules().empty() && function->Rules().back()->Precedence() > precedence)
+            Invalid();
+
+        LispPtr predicate;
+        if (ruleKind != RuleTruePredicate)
+            predicate = Object();
+        LispPtr body(Object());
+
+        switch (ruleKind) {
+        case RuleTruePredicate:
+            function->AppendRule(new BranchingUserFunction::BranchRuleTruePredicate(precedence, body));
+            break;
+        case RulePredicate:
+            function->AppendRule(new BranchingUserFunction::BranchRule(precedence, predicate, body));
+            break;
+        case RulePattern:
+            if (!predicate)
+                Invalid();
+            function->AppendRule(new BranchingUserFunction::BranchPattern(precedence, predicate, body));
+            break;
+        default:
+            Invalid();
+        }
+    }
+
+    if (memo)
+        function->Memoize(memo);
+
+    return function;
+}
+
+void Write(std::ostream& aOutput, const char* aMagic, const std::string& aPayload)
+{
+    Writer header;
+    header.Unsigned(FormatVersion);
+    header.String(YACAS_VERSION);
+    header.Unsigned(aPayload.size());
+    header.Unsigned(Fingerprint(aPayload.data(), aPayload.size()));
+
+    aOutput.write(aMagic, sizeof Magic);
+    aOutput << header.Data() << aPayload;
+}
+
+// Reads the magic bytes and the header, and checks that the rest of
+// the file is what was written by this version
+bool ReadHeader(Reader& aReader, const std::string& aFile, const char* aMagic)
+{
+    if (aFile.compare(0, sizeof Magic, aMagic, sizeof Magic) != 0)
+        return false;
+
+    aReader.Skip(sizeof Magic);
+
+    try {
+        if (aReader.Unsigned() != FormatVersion || aReader.String() != YACAS_VERSION)
+            return false;
+
+        const std::uint64_t size = aReader.Unsigned();
+        const std::uint64_t fingerprint = aReader.Unsigned();
+        return size == aReader.Remaining() && fingerprint == Fingerprint(aReader.Position(), size);
+    } catch (const LispError&) {
+        return false;
+    }
+}
+
+// Writes how aName is defined in each of the operator tables
+void WriteOperator(Writer& aWriter, LispEnvironment& aEnvironment, const LispString* aName)
+{
+    const LispOperators* const operators[] = {
+        &aEnvironment.PreFix(),
+        &aEnvironment.InFix(),
+        &aEnvironment.PostFix(),
+        &aEnvironment.Bodied()
+    };
+
+    for (const LispOperators* table: operators) {
+        auto i = table->find(aName);
+        if (i == table->end()) {
+            aWriter.Unsigned(0);
+        } else {
+            aWriter.Unsigned(1);
+            aWriter.Signed(i->second.iPrecedence);
+            aWriter.Signed(i->second.iLeftPrecedence);
+            aWriter.Signed(i->second.iRightPrecedence);
+            aWriter.Unsigned(i->second.iRightAssociative ? 1 : 0);
+        }
+    }
+}
+
+// Reads what WriteOperator wrote, and checks that aName is still
+// defined that way
+bool SameOperator(Reader& aReader, LispEnvironment& aEnvironment, const LispString* aName)
+{
+    Writer current;
+    WriteOperator(current, aEnvironment, aName);
+
+    const std::string& expected = current.Data();
+    if (aReader.Remaining() < expected.size() ||
+        expected.compare(0, expected.size(), aReader.Position(), expected.size()) != 0)
+        return false;
+
+    aReader.Skip(expected.size());
+    return true;
+}
+
+}
+
+void SaveSnapshot(LispEnvironment& aEnvironment, std::ostream& aOutput, bool aClone)
+{
+    Writer data;
+
+    data.Signed(aEnvironment.Precision());
+    data.Symbol(aEnvironment.PrettyPrinter());
+    data.Symbol(aEnvironment.PrettyReader());
+    data.Signed(aEnvironment.iLastUniqueId);
+    data.Signed(aEnvironment.iMaxEvalDepth);
+
+    LispOperators* const operators[] = {
+        &aEnvironment.PreFix(),
+        &aEnvironment.InFix(),
+        &aEnvironment.PostFix(),
+        &aEnvironment.Bodied()
+    };
+
+    for (const LispOperators* table: operators) {
+        data.Unsigned(table->size());
+        for (const LispOperators::value_type& op: *table) {
+            data.Symbol(op.first);
+            data.Signed(op.second.iPrecedence);
+            data.Signed(op.second.iLeftPrecedence);
+            data.Signed(op.second.iRightPrecedence);
+            data.Unsigned(op.second.iRightAssociative ? 1 : 0);
+        }
+    }
+
+    const LispDefFiles& defFiles = aEnvironment.DefFiles();
+    std::unordered_map<const LispDefFile*, std::size_t> defFileIndex;
+    data.Unsigned(std::distance(defFiles.begin(), defFiles.end()));
+    for (const LispDefFiles::const_iterator::value_type& f: defFiles) {
+        const std::size_t index = defFileIndex.size() + 1;
+        defFileIndex.insert(std::make_pair(&f.second, index));
+        data.String(f.first);
+        data.Unsigned(f.second.IsLoaded() ? 1 : 0);
+        data.Unsigned(f.second.symbols.size());
+        for (const LispString* symbol: f.second.symbols)
+            data.Symbol(symbol);
+    }
+
+    data.Unsigned(aEnvironment.Globals().size());
+    for (const LispGlobal::value_type& g: aEnvironment.Globals()) {
+        data.Symbol(g.first);
+        data.Unsigned(g.second.iEvalBeforeReturn ? 1 : 0);
+        data.Object(g.second.iValue);
+    }
+
+    data.Unsigned(aEnvironment.UserFunctions().size());
+    for (const LispUserFunctions::value_type& f: aEnvironment.UserFunctions()) {
+        data.Symbol(f.first);
+        data.Unsigned(f.second.iFileToOpen ? defFileIndex[f.second.iFileToOpen] : 0);
+        data.Unsigned(f.second.Functions().size());
+        for (const LispArityUserFunction* function: f.second.Functions())
+            data.Function(*function);
+    }
+
+    data.Unsigned(aEnvironment.ProtectedSymbols().size());
+    for (const LispStringSmartPtr& symbol: aEnvironment.ProtectedSymbols())
+        data.Symbol(symbol);
+
+    Writer contents;
+
+    contents.Unsigned(aEnvironment.iLoadedFiles.size());
+    for (const std::string& name: aEnvironment.iLoadedFiles) {
+        // the files of a clone are written with size and fingerprint
+        // zero, which no file has both of, so that its snapshot never
+        // passes for one of the files on disk
+        std::string file;
+        if (!aClone && !ReadFile(InternalFindFile(name.c_str(), aEnvironment.iInputDirectories), file))
+            throw LispErrFileNotFound();
+        contents.String(name);
+        contents.Unsigned(file.size());
+        contents.Unsigned(aClone ? 0 : Fingerprint(file.data(), file.size()));
+    }
+
+    contents.Unsigned(data.Symbols().size());
+    for (const LispString* symbol: data.Symbols())
+        contents.String(*symbol);
+
+    Write(aOutput, Magic, contents.Data() + data.Data());
+
+    if (!aOutput)
+        throw LispErrGeneric("Snapshot'Save: error writing snapshot");
+}
+
+bool LoadSnapshot(LispEnvironment& aEnvironment, std::istream& aInput, bool aClone)
+{
+    if (!aEnvironment.UserFunctions().empty())
+        throw LispErrGeneric("Snapshot'Load: functions have been defined already");
+
+    const std::string snapshot((std::istreambuf_iterator<char>(aInput)), std::istreambuf_iterator<char>());
+
+    Reader reader(aEnvironment, snapshot.data(), snapshot.data() + snapshot.size());
+    if (!ReadHeader(reader, snapshot, Magic))
+        return false;
+
+    std::vector<std::string> loadedFiles;
+
+    try {
+        for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+            const std::string name = reader.String();
+            const std::uint64_t size = reader.Unsigned();
+            const std::uint64_t fingerprint = reader.Unsigned();
+
+            if (aClone) {
+                loadedFiles.push_back(name);
+                continue;
+            }
+
+            std::string file;
+            if (!ReadFile(InternalFindFile(name.c_str(), aEnvironment.iInputDirectories), file))
+                return false;
+            if (file.size() != size || Fingerprint(file.data(), file.size()) != fingerprint)
+                return false;
+
+            loadedFiles.push_back(name);
+        }
+    } catch (const LispError&) {
+        return false;
+    }
+
+    reader.Symbols();
+
+    aEnvironment.SetPrecision(reader.Int());
+    aEnvironment.SetPrettyPrinter(reader.Symbol());
+    aEnvironment.SetPrettyReader(reader.Symbol());
+    aEnvironment.iLastUniqueId = reader.Int();
+    aEnvironment.iMaxEvalDepth = reader.Int();
+
+    LispOperators* const operators[] = {
+        &aEnvironment.PreFix(),
+        &aEnvironment.InFix(),
+        &aEnvironment.PostFix(),
+        &aEnvironment.Bodied()
+    };
+
+    for (LispOperators* table: operators) {
+        for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+            const LispString* symbol = reader.Name();
+            LispInFixOperator op(reader.Int());
+            op.SetLeftPrecedence(reader.Int());
+            op.SetRightPrecedence(reader.Int());
+            if (reader.Unsigned())
+                op.SetRightAssociative();
+            (*table)[symbol] = op;
+        }
+    }
+
+    std::vector<LispDefFile*> defFiles;
+    for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+        LispDefFile* def = aEnvironment.DefFiles().File(reader.String());
+        if (reader.Unsigned())
+            def->SetLoaded();
+        for (std::uint64_t m = reader.Unsigned(); m > 0; --m)
+            def->symbols.insert(reader.Name());
+        defFiles.push_back(def);
+    }
+
+    for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+        const LispString* symbol = reader.Name();
+        const bool lazy = reader.Unsigned() != 0;
+        LispPtr value(reader.Object());
+
+        // some symbols are protected by the environment itself
+        const bool protect = aEnvironment.Protected(symbol);
+        aEnvironment.UnProtect(symbol);
+        aEnvironment.SetVariable(symbol, value, lazy);
+        if (protect)
+            aEnvironment.Protect(symbol);
+    }
+
+    for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+        LispMultiUserFunction* multiUserFunc = aEnvironment.MultiUserFunction(reader.Name());
+
+        const std::uint64_t def = reader.Unsigned();
+        if (def > defFiles.size())
+            Reader::Invalid();
+        multiUserFunc->iFileToOpen = def ? defFiles[def - 1] : nullptr;
+
+        for (std::uint64_t m = reader.Unsigned(); m > 0; --m) {
+            std::unique_ptr<BranchingUserFunction> function(reader.Function());
+            multiUserFunc->DefineRuleBase(function.get());
+            function.release();
+        }
+    }
+
+    for (std::uint64_t n = reader.Unsigned(); n > 0; --n)
+        aEnvironment.Protect(reader.Name());
+
+    if (reader.Remaining())
+        Reader::Invalid();
+
+    aEnvironment.iLoadedFiles = loadedFiles;
+    aEnvironment.InvalidateDispatchCache();
+
+    return true;
+}
+
+std::string SaveExpression(LispObject* aExpression)
+{
+    Writer data;
+    data.Object(aExpression);
+
+    Writer contents;
+    contents.Unsigned(data.Symbols().size());
+    for (const LispString* symbol: data.Symbols())
+        contents.String(*symbol);
+
+    return contents.Data() + data.Data();
+}
+
+LispPtr LoadExpression(LispEnvironment& aEnvironment, const std::string& aData)
+{
+    Reader reader(aEnvironment, aData.data(), aData.data() + aData.size());
+    reader.Symbols();
+
+    LispPtr expression(reader.Object());
+    if (reader.Remaining())
+        Reader::Invalid();
+
+    return expression;
+}
+
+class ScriptCompiler::Expressions: public Writer {
+public:
+    std::string iOperators;
+    std::uint64_t iCount;
+};
+
+ScriptCompiler::ScriptCompiler(LispEnvironment& aEnvironment, LispInput& aSource, const std::string& aSourceText):
+    iExpressions(new Expressions)
+{
+    // The parser looks up each token in the operator tables, and may
+    // split symbolic tokens into operators, so the script is parsed
+    // the same way as long as these are defined the same way.
+    std::set<std::string> names;
+    LispTokenizer tokenizer;
+    for (;;) {
+        const std::string& token = *tokenizer.NextToken(aSource, aEnvironment.HashTable());
+        if (token.empty())
+            break;
+        if (IsSymbolic(token[0])) {
+            for (std::size_t i = 0; i < token.size(); ++i)
+                for (std::size_t n = 1; i + n <= token.size(); ++n)
+                    names.insert(token.substr(i, n));
+        } else {
+            names.insert(token);
+        }
+    }
+    aSource.SetPosition(0);
+
+    Writer operators;
+    operators.Unsigned(aSourceText.size());
+    operators.Unsigned(Fingerprint(aSourceText.data(), aSourceText.size()));
+    operators.Unsigned(names.size());
+    for (const std::string& name: names) {
+        operators.String(name);
+        WriteOperator(operators, aEnvironment, aEnvironment.HashTable().LookUp(name));
+    }
+
+    iExpressions->iOperators = operators.Data();
+    iExpressions->iCount = 0;
+}
+
+ScriptCompiler::~ScriptCompiler()
+{
+}
+
+void ScriptCompiler::Add(LispObject* aExpression)
+{
+    iExpressions->Object(aExpression);
+    iExpressions->iCount += 1;
+}
+
+void ScriptCompiler::Save(std::ostream& aOutput)
+{
+    Writer contents;
+    contents.Unsigned(iExpressions->Symbols().size());
+    for (const LispString* symbol: iExpressions->Symbols())
+        contents.String(*symbol);
+    contents.Unsigned(iExpressions->iCount);
+
+    Write(aOutput, CompiledMagic, iExpressions->iOperators + contents.Data() + iExpressions->Data());
+
+    if (!aOutput)
+        throw LispErrGeneric("error writing compiled script");
+}
+
+bool LoadCompiledScript(LispEnvironment& aEnvironment, std::istream& aInput, const std::string& aSourceText)
+{
+    const std::string script((std::istreambuf_iterator<char>(aInput)), std::istreambuf_iterator<char>());
+
+    Reader reader(aEnvironment, script.data(), script.data() + script.size());
+    if (!ReadHeader(reader, script, CompiledMagic))
+        return false;
+
+    try {
+        const std::uint64_t size = reader.Unsigned();
+        const std::uint64_t fingerprint = reader.Unsigned();
+        if (size != aSourceText.size() || fingerprint != Fingerprint(aSourceText.data(), aSourceText.size()))
+            return false;
+
+        for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+            const LispString* name = aEnvironment.HashTable().LookUp(reader.String());
+            if (!SameOperator(reader, aEnvironment, name))
+                return false;
+        }
+    } catch (const LispError&) {
+        return false;
+    }
+
+    reader.Symbols();
+
+    // each expression is read just before it is evaluated, as the
+    // script may change the precision numbers are read at
+    for (std::uint64_t n = reader.Unsigned(); n > 0; --n) {
+        LispPtr expression(reader.Object());
+        if (!expression)
+            Reader::Invalid();
+        LispPtr result;
+        aEnvironment.iEvaluator->Eval(aEnvironment, result, expression);
+    }
+
+    if (reader.Remaining())
+        Reader::Invalid();
+
+    return true;
+}
@@ -14,7 +14,13 @@
 #include "yacas/lispeval.h"
 #include "yacas/stringio.h"
 #include "yacas/numbers.h"
+#include "yacas/snapshot.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <sstream>
 
 bool InternalIsList(const LispEnvironment& env, const LispPtr& aPtr)
@@ -170,6 +176,24 @@ void InternalFlatCopy(LispPtr& aResult, const LispPtr& aOriginal)
     }
 }
 
+void InternalDeepCopy(LispPtr& aResult, LispPtr& aOriginal)
+{
+    LispPtr* subList = aOriginal->SubList();
+    if (!subList) {
+        aResult = aOriginal->Copy();
+        return;
+    }
+
+    LispPtr copied;
+    LispPtr* next = &copied;
+    for (LispObject* element = *subList; element; element = element->Nixed()) {
+        LispPtr original(element);
+        InternalDeepCopy(*next, original);
+        next = &(*next)->Nixed();
+    }
+    aResult = LispSubList::New(copied);
+}
+
 std::size_t InternalListLength(const LispPtr& aOriginal)
 {
     LispConstIterator iter(aOriginal);
@@ -242,6 +266,9 @@ bool InternalStrictTotalOrder(
         return false;
 
     if (l1 && l2) {
+        if (l1->ptr() == l2->ptr())
+            return false;
+
         LispIterator i1(*l1);
         LispIterator i2(*l2);
         
@@ -275,6 +302,88 @@ bool InternalStrictTotalOrder(
     return false;
 }
 
+static std::size_t CombineHash(std::size_t aSeed, std::size_t aValue)
+{
+    return aSeed ^ (aValue + 0x9e3779b9 + (aSeed << 6) + (aSeed >> 2));
+}
+
+static std::size_t HashNumber(double aValue, bool aExact)
+{
+    const std::size_t h = std::hash<double>()(aValue == 0 ? 0.0 : aValue);
+    return aExact ? (h | 1) : (h & ~std::size_t(1));
+}
+
+// Integers from 2^53 on don't all fit in a double, so they are hashed by
+// their decimal digits, which are the same however they are held
+static const std::int64_t DoubleIntegerLimit = std::int64_t(1) << 53;
+
+static std::size_t HashDigits(const std::string& aDigits)
+{
+    return std::hash<std::string>()(aDigits) | 1;
+}
+
+std::size_t InternalHash(const LispEnvironment& aEnvironment,
+                         const LispPtr& aExpression)
+{
+    LispObject* object = aExpression.ptr();
+
+    if (!object)
+        return 1;
+
+    std::int64_t i;
+    if (object->SmallInteger(i)) {
+        if (i > -DoubleIntegerLimit && i < DoubleIntegerLimit)
+            return HashNumber(static_cast<double>(i), true);
+        return HashDigits(std::to_string(i));
+    }
+
+    if (BigNumber* n = object->Number(aEnvironment.Precision())) {
+        if (n->IsInt() && n->BitCount() > 53) {
+            LispString digits;
+            n->ToString(digits, aEnvironment.Precision());
+            return HashDigits(digits);
+        }
+        return HashNumber(n->Double(), n->IsInt());
+    }
+
+    if (const LispString* s = object->String())
+        return std::hash<const LispString*>()(s) | 1;
+
+    if (LispPtr* list = object->SubList()) {
+        // only lists return a sublist
+        LispSubList* sublist = static_cast<LispSubList*>(object);
+
+        std::size_t h;
+        if (sublist->CachedHash(aEnvironment.HashGeneration(), h))
+            return h;
+
+        h = 1;
+        bool exact = true;
+        for (LispIterator iter(*list); iter.getObj(); ++iter) {
+            const std::size_t e = InternalHash(aEnvironment, *iter);
+            exact = exact && InternalHashIsExact(e);
+            h = CombineHash(h, e);
+        }
+        h = exact ? (h | 1) : (h & ~std::size_t(1));
+
+        sublist->CacheHash(aEnvironment.HashGeneration(), h);
+        return h;
+    }
+
+    // InternalEquals() finds all generic objects equal, though they are
+    // not the same
+    return 2;
+}
+
+// Whether aObject is a list with an exact hash cached
+static bool CachedExactHash(const LispEnvironment& aEnvironment,
+                            LispObject* aObject,
+                            std::size_t& aHash)
+{
+    return static_cast<LispSubList*>(aObject)->CachedHash(aEnvironment.HashGeneration(), aHash) &&
+           InternalHashIsExact(aHash);
+}
+
 bool InternalEquals(const LispEnvironment& aEnvironment,
                     const LispPtr& aExpression1,
                     const LispPtr& aExpression2)
@@ -286,6 +395,10 @@ bool InternalEquals(const LispEnvironment& aEnvironment,
     if (!aExpression1.ptr() || !aExpression2.ptr())
         return false;
 
+    std::int64_t i1, i2;
+    if (aExpression1->SmallInteger(i1) && aExpression2->SmallInteger(i2))
+        return i1 == i2;
+
 /*TODO This code would be better, if BigNumber::Equals works*/
 
     BigNumber *n1 = aExpression1->Number(aEnvironment.Precision());
@@ -323,6 +436,17 @@ bool InternalEquals(const LispEnvironment& aEnvironment,
         {
             return false;
         }
+
+        // Lists sharing their elements, like hash-consed ones
+        if (aExpression1->SubList()->ptr() == aExpression2->SubList()->ptr())
+            return true;
+
+        std::size_t h1, h2;
+        if (CachedExactHash(aEnvironment, aExpression1.ptr(), h1) &&
+            CachedExactHash(aEnvironment, aExpression2.ptr(), h2) &&
+            h1 != h2)
+            return false;
+
         LispIterator iter1(*aExpression1->SubList());
         LispIterator iter2(*aExpression2->SubList());
 
@@ -350,7 +474,7 @@ bool InternalEquals(const LispEnvironment& aEnvironment,
     return false;
 }
 
-void DoInternalLoad(LispEnvironment& aEnvironment,LispInput* aInput)
+void DoInternalLoad(LispEnvironment& aEnvironment,LispInput* aInput, ScriptCompiler* aCompiler)
 {
     LispLocalInput localInput(aEnvironment, aInput);
 
@@ -385,6 +509,9 @@ void DoInternalLoad(LispEnvironment& aEnvironment,LispInput* aInput)
         // Else evaluate
         else
         {
+            if (aCompiler)
+                aCompiler->Add(readIn);
+
             LispPtr result;
             aEnvironment.iEvaluator->Eval(aEnvironment, result, readIn);
         }
@@ -406,8 +533,34 @@ void InternalLoad(LispEnvironment& aEnvironment, const std::string& aFileName)
     if (!localFP.stream.is_open())
         throw LispErrFileNotFound();
 
-    StdFileInput newInput(localFP, aEnvironment.iInputStatus);
-    DoInternalLoad(aEnvironment, &newInput);
+    std::vector<std::string>& loaded = aEnvironment.iLoadedFiles;
+    if (std::find(loaded.begin(), loaded.end(), oper) == loaded.end())
+        loaded.push_back(oper);
+
+    // the compiled script is kept next to the source, and used only if
+    // it was compiled from the text read now, whatever the times of the
+    // files say
+    const std::string compiled =
+        InternalFindFile(oper.c_str(), aEnvironment.iInputDirectories) + "c";
+    const std::string text((std::istreambuf_iterator<char>(localFP.stream)), std::istreambuf_iterator<char>());
+    std::istringstream source(text);
+
+    if (aEnvironment.iCompileScripts) {
+        StdFileInput newInput(source, aEnvironment.iInputStatus);
+        ScriptCompiler compiler(aEnvironment, newInput, text);
+        DoInternalLoad(aEnvironment, &newInput, &compiler);
+
+        std::ofstream file(compiled, std::ios::binary);
+        if (!file)
+            throw LispErrGeneric("Cannot write " + compiled);
+        compiler.Save(file);
+    } else {
+        std::ifstream file(compiled, std::ios::binary);
+        if (!file || !LoadCompiledScript(aEnvironment, file, text)) {
+            StdFileInput newInput(source, aEnvironment.iInputStatus);
+            DoInternalLoad(aEnvironment, &newInput);
+        }
+    }
 
     aEnvironment.iInputStatus.RestoreFrom(oldstatus);
 }
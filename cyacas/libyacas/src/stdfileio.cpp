@@ -16,7 +16,9 @@ static void MapPathSeparators(std::string& filename)
 
 StdFileInput::StdFileInput(std::istream& stream, InputStatus& aStatus):
     LispInput(aStatus),
-    _stream(stream)
+    _stream(stream),
+    _position(0),
+    _cp_ready(false)
 {
 }
 
@@ -55,6 +57,7 @@ char32_t StdFileInput::Peek()
 
 void StdFileInput::Rewind()
 {
+    _stream.clear();
     _stream.seekg(0);
     _position = 0;
     _cp_ready = false;
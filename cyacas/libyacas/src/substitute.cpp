@@ -3,33 +3,64 @@
 #include "yacas/standard.h"
 #include "yacas/lispeval.h"
 
-//Subst, Substitute, FullSubstitute
-void InternalSubstitute(LispPtr& aTarget, LispPtr& aSource,
-                        SubstBehaviourBase& aBehaviour)
+namespace {
+
+// Substitute in aSource and return true if the result differs from it,
+// in which case aTarget holds the result. Unless the behaviour asks for
+// a fresh copy, lists in which nothing changes are not rebuilt, so that
+// the result shares them with the source, the same way a copy of a list
+// shares its elements.
+bool Substitute(LispPtr& aTarget, LispPtr& aSource,
+                SubstBehaviourBase& aBehaviour)
 {
     LispObject* object = aSource;
     assert(object);
-    if (!aBehaviour.Matches(aTarget,aSource))
-    {
-        LispPtr* oldList = object->SubList();
-        if (oldList)
-        {
-            LispPtr newList;
-            LispPtr* next = &newList;
-            while (!!(*oldList))
-            {
-                InternalSubstitute(*next, *oldList, aBehaviour);
-                oldList = &(*oldList)->Nixed();
-                next = &(*next)->Nixed();
-            }
 
-            aTarget = (LispSubList::New(newList));
-        }
-        else
-        {
-            aTarget = (object->Copy());
+    if (aBehaviour.Matches(aTarget, aSource))
+        return aTarget.ptr() != object;
+
+    LispPtr* oldList = object->SubList();
+    if (!oldList)
+        return false;
+
+    LispPtr newList;
+    LispPtr* next = &newList;
+    bool changed = !aBehaviour.ShareUnchanged();
+
+    for (LispObject* element = *oldList; element; element = element->Nixed()) {
+        LispPtr source(element);
+        LispPtr substituted;
+        if (Substitute(substituted, source, aBehaviour)) {
+            if (!changed) {
+                for (LispObject* p = *oldList; p != element; p = p->Nixed()) {
+                    *next = p->Copy();
+                    next = &(*next)->Nixed();
+                }
+                changed = true;
+            }
+            *next = substituted;
+        } else if (changed) {
+            *next = element->Copy();
         }
+
+        if (changed)
+            next = &(*next)->Nixed();
     }
+
+    if (changed)
+        aTarget = LispSubList::New(newList);
+
+    return changed;
+}
+
+}
+
+//Subst, Substitute, FullSubstitute
+void InternalSubstitute(LispPtr& aTarget, LispPtr& aSource,
+                        SubstBehaviourBase& aBehaviour)
+{
+    if (!Substitute(aTarget, aSource, aBehaviour))
+        aTarget = aSource->Copy();
 }
 
 SubstBehaviour::SubstBehaviour(LispEnvironment& aEnvironment,
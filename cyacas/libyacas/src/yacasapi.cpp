@@ -3,11 +3,16 @@
 #include "yacas/mathcommands.h"
 #include "yacas/standard.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #define OPERATOR(kind,prec,name) \
   kind##operators[hash.LookUp(#name)] = LispInFixOperator(prec);
 
 DefaultYacasEnvironment::DefaultYacasEnvironment(std::ostream& os)
-  : output(os),
+  : constructing(new Arena::Scope(&arena)),
+    output(os),
     infixprinter(prefixoperators,
                  infixoperators,
                  postfixoperators,
@@ -27,6 +32,8 @@ DefaultYacasEnvironment::DefaultYacasEnvironment(std::ostream& os)
 #undef CORE_KERNEL_FUNCTION
 #undef CORE_KERNEL_FUNCTION_ALIAS
 #undef OPERATOR
+
+    constructing.reset();
 }
 
 
@@ -37,6 +44,8 @@ CYacas::CYacas(std::ostream& os):
 
 void CYacas::Evaluate(const std::string& aExpression)
 {
+    Arena::Scope scope(&environment.getArena());
+
     LispEnvironment& env = environment.getEnv();
     int stackTop = env.iStack.size();
 
@@ -49,6 +58,8 @@ void CYacas::Evaluate(const std::string& aExpression)
 
     try
      {
+         env.StartBudget();
+
          LispPtr lispexpr;
 //printf("Input: [%s]\n",aExpression);
          if (env.PrettyReader())
@@ -114,3 +125,53 @@ void CYacas::Evaluate(const std::string& aExpression)
      _result = iResultOutput.str();
      _error = env.iErrorOutput.str();
 }
+
+void CYacas::Evaluate(const std::string& aExpression, BatchResult& aResult)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    Evaluate(aExpression);
+
+    aResult.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    aResult.result = _result;
+    aResult.error = _error;
+}
+
+std::vector<CYacas::BatchResult> CYacas::EvaluateBatch(const std::vector<std::string>& aExpressions)
+{
+    std::vector<BatchResult> results(aExpressions.size());
+
+    for (std::size_t i = 0; i < aExpressions.size(); ++i)
+        Evaluate(aExpressions[i], results[i]);
+
+    return results;
+}
+
+std::vector<CYacas::BatchResult> CYacas::EvaluateBatch(
+    const std::vector<CYacas*>& aWorkers,
+    const std::vector<std::string>& aExpressions)
+{
+    if (aWorkers.size() < 2)
+        return aWorkers.empty() ? std::vector<BatchResult>() : aWorkers.front()->EvaluateBatch(aExpressions);
+
+    std::vector<BatchResult> results(aExpressions.size());
+
+    std::atomic<std::size_t> next(0);
+
+    auto work = [&](CYacas* yacas) {
+        for (std::size_t i; (i = next++) < aExpressions.size(); )
+            yacas->Evaluate(aExpressions[i], results[i]);
+    };
+
+    // the calling thread is one of the workers
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < aWorkers.size(); ++i)
+        threads.emplace_back(work, aWorkers[i]);
+
+    work(aWorkers.front());
+
+    for (std::thread& thread: threads)
+        thread.join();
+
+    return results;
+}
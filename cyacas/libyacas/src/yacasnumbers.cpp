@@ -3,6 +3,7 @@
  */
 
 #include "yacas/numbers.h"
+#include "yacas/lispatom.h"
 #include "yacas/standard.h"
 #include "yacas/anumber.h"
 #include "yacas/platmath.h"
@@ -13,6 +14,7 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cstdlib>
 
 static LispObject* FloatToString(ANumber& aInt, LispEnvironment& aEnvironment, int aBase = 10);
 
@@ -37,6 +39,111 @@ LispObject* GcdInteger(LispObject* int1, LispObject* int2,
   return new LispNumber(res);
 }
 
+/// Sums, differences and products of integers smaller than this in
+/// absolute value are computed in machine words when they fit.
+static const std::int64_t SmallOperandLimit = std::int64_t(1) << 62;
+
+/// The number aObject, if it is an integer held in a machine word
+/// smaller than SmallOperandLimit, with its value in x
+static LispNumber* SmallOperand(LispObject* aObject, std::int64_t& x)
+{
+    if (!aObject->SmallInteger(x) || x <= -SmallOperandLimit || x >= SmallOperandLimit)
+        return nullptr;
+    // only LispNumber holds small integers
+    return static_cast<LispNumber*>(aObject);
+}
+
+LispObject* AddNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment)
+{
+    std::int64_t a, b;
+    LispNumber* na = SmallOperand(int1, a);
+    LispNumber* nb = SmallOperand(int2, b);
+    if (na && nb) {
+        // the precisions BigNumber::Add would give the sum
+        const int bin = aEnvironment.BinaryPrecision();
+        const int precision = std::max(bin, std::max(na->SmallPrecision(), nb->SmallPrecision()));
+        return new LispNumber(a + b, bin, precision);
+    }
+
+    BigNumber* x = int1->Number(aEnvironment.Precision());
+    BigNumber* y = int2->Number(aEnvironment.Precision());
+    if (!x || !y)
+        return nullptr;
+
+    BigNumber* z = new BigNumber(aEnvironment.BinaryPrecision());
+    z->Add(*x, *y, aEnvironment.BinaryPrecision());
+    return new LispNumber(z);
+}
+
+LispObject* SubtractNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment)
+{
+    std::int64_t a, b;
+    LispNumber* na = SmallOperand(int1, a);
+    LispNumber* nb = SmallOperand(int2, b);
+    if (na && nb) {
+        const int bin = aEnvironment.BinaryPrecision();
+        const int precision = std::max(bin, std::max(na->SmallPrecision(), nb->SmallPrecision()));
+        return new LispNumber(a - b, bin, precision);
+    }
+
+    BigNumber* x = int1->Number(aEnvironment.Precision());
+    BigNumber* y = int2->Number(aEnvironment.Precision());
+    if (!x || !y)
+        return nullptr;
+
+    BigNumber yneg(*y);
+    yneg.Negate(yneg);
+    BigNumber* z = new BigNumber(aEnvironment.BinaryPrecision());
+    z->Add(*x, yneg, aEnvironment.BinaryPrecision());
+    return new LispNumber(z);
+}
+
+LispObject* MultiplyNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment)
+{
+    std::int64_t a, b;
+    LispNumber* na = SmallOperand(int1, a);
+    LispNumber* nb = SmallOperand(int2, b);
+    if (na && nb && (a == 0 || std::abs(b) < SmallOperandLimit / std::abs(a))) {
+        // the precisions BigNumber::Multiply would give the product
+        const int bin = aEnvironment.BinaryPrecision();
+        const int precision = std::max(bin, std::max(na->SmallPrecision(), nb->SmallPrecision()));
+        return new LispNumber(a * b, bin, bits_to_digits(precision, BASE10));
+    }
+
+    BigNumber* x = int1->Number(aEnvironment.Precision());
+    BigNumber* y = int2->Number(aEnvironment.Precision());
+    if (!x || !y)
+        return nullptr;
+
+    BigNumber* z = new BigNumber(aEnvironment.BinaryPrecision());
+    z->Multiply(*x, *y, aEnvironment.BinaryPrecision());
+    return new LispNumber(z);
+}
+
+LispObject* DivideNumbers(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment)
+{
+    BigNumber* x = int1->Number(aEnvironment.Precision());
+    BigNumber* y = int2->Number(aEnvironment.Precision());
+    if (!x || !y)
+        return nullptr;
+
+    BigNumber* z = new BigNumber(aEnvironment.BinaryPrecision());
+    // if both arguments are integers, then BigNumber::Divide would
+    // perform an integer divide, but we want a float divide here
+    if (x->IsInt() && y->IsInt()) {
+        BigNumber tempx(aEnvironment.BinaryPrecision());
+        tempx.SetTo(*x);
+        tempx.BecomeFloat(aEnvironment.BinaryPrecision());
+        BigNumber tempy(aEnvironment.BinaryPrecision());
+        tempy.SetTo(*y);
+        tempy.BecomeFloat(aEnvironment.BinaryPrecision());
+        z->Divide(tempx, tempy, aEnvironment.BinaryPrecision());
+    } else {
+        z->Divide(*x, *y, aEnvironment.BinaryPrecision());
+    }
+    return new LispNumber(z);
+}
+
 LispObject* PowerFloat(LispObject* int1, LispObject* int2, LispEnvironment& aEnvironment,int aPrecision)
 {
     if (int2->Number(aPrecision)->iNumber->iExp != 0)
@@ -153,54 +260,39 @@ static LispObject* FloatToString(ANumber& aInt,
 }
 
 
-LispObject* LispFactorial(LispObject* int1, LispEnvironment& aEnvironment,int aPrecision)
+// Set aResult to the product of the integers aLeft..aRight. Splitting the
+// range in halves keeps the operands of the large multiplications balanced,
+// so that the fast multiplication methods can be used.
+static void RangeProduct(ANumber& aResult, int aLeft, int aRight)
 {
-    int nr = InternalAsciiToInt(*int1->String());
-
-    if (nr < 0)
-        throw LispErrInvalidArg();
-
-    ANumber fac("1",aPrecision);
-    int i;
-    for (i=2;i<=nr;i++)
+    if (aRight - aLeft < 16)
     {
-        BaseTimesInt(fac,i, WordBase);
+        aResult.SetTo("1");
+        for (int i = aLeft; i <= aRight; i++)
+            BaseTimesInt(aResult, i, WordBase);
+        return;
     }
-    return FloatToString(fac, aEnvironment);
-}
-
-/* This code will compute factorials faster when multiplication becomes better than quadratic time
 
-// return old result*product of all integers from iLeft to iRight
-void tree_factorial(ANumber& result, int iLeft, int iRight, int aPrecision)
-{
-  if (iRight == iLeft) BaseTimesInt(result, iLeft, WordBase);
-  else if (iRight == iLeft + 1) BaseTimesInt(result, iLeft*iRight, WordBase);
-  else if (iRight == iLeft + 2) BaseTimesInt(result, iLeft*iRight*(iLeft+1), WordBase);
-  else
-  {
-      ANumber fac1("1", aPrecision), fac2("1", aPrecision);
-      int i = (iLeft+iRight)>>1;
-    tree_factorial(fac1, iLeft, i, aPrecision);
-    tree_factorial(fac2, i+1, iRight, aPrecision);
-    Multiply(result, fac1, fac2);
-  }
+    const int mid = (aLeft + aRight) / 2;
+    ANumber left(aResult.iPrecision), right(aResult.iPrecision);
+    RangeProduct(left, aLeft, mid);
+    RangeProduct(right, mid + 1, aRight);
+    Multiply(aResult, left, right);
 }
 
-LispString * LispFactorial(LispChar * int1, LispHashTable& aHashTable,int aPrecision)
+LispObject* LispFactorial(LispObject* int1, LispEnvironment& aEnvironment,int aPrecision)
 {
-    int nr = InternalAsciiToInt(int1);
+    int nr = InternalAsciiToInt(*int1->String());
 
     if (nr < 0)
         throw LispErrInvalidArg();
 
-  ANumber fac("1",aPrecision);
-  tree_factorial(fac, 1, nr, aPrecision);
+    ANumber fac("1",aPrecision);
+    if (nr >= 2)
+        RangeProduct(fac, 2, nr);
     return FloatToString(fac, aEnvironment);
 }
 
-*/
-
 
 
 // this will use the new BigNumber/BigInt/BigFloat scheme
@@ -770,7 +862,7 @@ bool BigNumber::Equals(const BigNumber& aOther) const
         pr = iPrecision;
       if (pr<aOther.iPrecision)
         pr = aOther.iPrecision;
-      NormalizeFloat(*diff.iNumber,WordDigits(pr, 10));
+      NormalizeFloat(*diff.iNumber,pr);
     }
 
     return !Significant(*diff.iNumber);
@@ -875,6 +967,24 @@ void BigNumber::SetTo(long aValue)
     SetIsInteger(true);
 }
 
+void BigNumber::SetTo(std::int64_t aValue, int aPrecision, int aMantissaPrecision)
+{
+  if (!iNumber) iNumber = new ANumber(aMantissaPrecision);
+
+  ANumber& a = *iNumber;
+  a.SetPrecision(aMantissaPrecision);
+  a.iExp = 0;
+  a.iTensExp = 0;
+  a.iNegative = aValue < 0;
+
+  std::uint64_t magnitude = a.iNegative ? 0 - std::uint64_t(aValue) : std::uint64_t(aValue);
+  a.assign(1, static_cast<PlatWord>(magnitude));
+  while (WordBits < 64 && (magnitude >>= WordBits % 64) != 0)
+    a.push_back(static_cast<PlatWord>(magnitude));
+
+  iPrecision = aPrecision;
+  SetIsInteger(true);
+}
 
 void BigNumber::SetTo(double aValue)
 {
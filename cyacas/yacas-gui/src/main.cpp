@@ -18,10 +18,6 @@ int main(int argc, char *argv[])
   QApplication app(argc, argv);
     
   try {
-    #ifndef NO_GLOBALS
-      PlatObSetThreadSafe(true);
-    #endif    
-
 	app.setApplicationName("yagy");
     app.setApplicationDisplayName("Yagy");
     app.setOrganizationName("yagy.sourceforge.net");
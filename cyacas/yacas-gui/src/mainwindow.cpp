@@ -55,7 +55,7 @@ MainWindow::MainWindow(Preferences& prefs, QWidget *parent) :
     connect(_yacas_server, SIGNAL(busy(bool)), this, SLOT(handle_engine_busy(bool)));
     
     _yacas2tex->Evaluate(((std::string("DefaultDirectory(\"") + _scripts_path.toStdString() + "\");")));
-    _yacas2tex->Evaluate("Load(\"yacasinit.ys\");");
+    _yacas2tex->Evaluate("If(Not(Snapshot'Load(\"yacasinit.snapshot\")),Load(\"yacasinit.ys\"));");
 
     _ui->setupUi(this);
 
@@ -447,7 +447,7 @@ void MainWindow::handle_prefs_changed()
         delete _yacas2tex;
         _yacas2tex = new CYacas(_null_stream);
         _yacas2tex->Evaluate(((std::string("DefaultDirectory(\"") + _scripts_path.toStdString() + "\");")).c_str());
-        _yacas2tex->Evaluate("Load(\"yacasinit.ys\");");
+        _yacas2tex->Evaluate("If(Not(Snapshot'Load(\"yacasinit.snapshot\")),Load(\"yacasinit.ys\"));");
     }
 }
 
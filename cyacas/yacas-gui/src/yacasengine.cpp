@@ -16,7 +16,7 @@ YacasEngine::YacasEngine(const QString& scripts_path, YacasRequestQueue& request
         throw std::runtime_error(QString("Invalid yacas scripts path: %1").arg(scripts_path).toStdString());
 
     _yacas->Evaluate(std::string("DefaultDirectory(\"") + scripts_path.toStdString() + std::string("\");"));
-    _yacas->Evaluate("Load(\"yacasinit.ys\");");
+    _yacas->Evaluate("If(Not(Snapshot'Load(\"yacasinit.snapshot\")),Load(\"yacasinit.ys\"));");
 
     _yacas->Evaluate("Plot2D'outputs();");
     _yacas->Evaluate("UnProtect(Plot2D'outputs);");
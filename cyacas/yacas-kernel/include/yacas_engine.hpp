@@ -30,47 +30,102 @@
 #include <zmqpp/zmqpp.hpp>
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
+#include <list>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <sstream>
 #include <thread>
+#include <vector>
 
-class YacasEngine {
+// A pool of independent yacas environments, each evaluating in its own
+// thread. Requests of one session are all evaluated by the same worker,
+// so that they see each other's definitions; requests without a session
+// go to the worker with the fewest requests pending. Only the most
+// recently used sessions are remembered, see max_sessions.
+class YacasEngine: NonCopyable {
 public:
     YacasEngine(
             const std::string& scripts_path,
             const zmqpp::context& ctx,
-            const std::string& endpoint = "inproc://engine");
+            const std::string& endpoint = "inproc://engine",
+            std::size_t nr_workers = 1,
+            const EvaluationBudget& budget = EvaluationBudget());
     
     ~YacasEngine();
     
-    void submit(unsigned long id, const std::string& expr);
+    void submit(unsigned long id, const std::string& expr, const std::string& session = "");
     
 private:
-    void _worker();
-    
-    std::ostringstream _side_effects;
-    CYacas _yacas;
-
     struct TaskInfo {
         unsigned long id;
         std::string expr;
+        std::chrono::steady_clock::time_point submitted;
     };
-    
-    std::deque<TaskInfo> _tasks;
-    
-    std::mutex _mtx;
-    std::condition_variable _cv;
 
-    std::thread* _worker_thread;
-    
-    zmqpp::socket _socket;
-    
-    std::atomic<bool> _shutdown;
+    class Worker: NonCopyable {
+    public:
+        Worker(
+                std::size_t index,
+                const std::string& scripts_path,
+                const zmqpp::context& ctx,
+                const std::string& endpoint,
+                const EvaluationBudget& budget);
+
+        ~Worker();
+
+        void submit(const TaskInfo& ti);
+
+        // requests waiting or being evaluated
+        std::size_t queue_depth();
+
+    private:
+        void _run();
+
+        const std::size_t _index;
+        const std::string _scripts_path;
+        const zmqpp::context& _ctx;
+        const std::string _endpoint;
+        // limits on each evaluation, once the scripts are loaded
+        const EvaluationBudget _budget;
+
+        std::deque<TaskInfo> _tasks;
+        bool _busy;
+        // created by the worker thread, so that the objects of its
+        // environment are allocated from its arena on that thread
+        CYacas* _yacas;
+
+        std::mutex _mtx;
+        std::condition_variable _cv;
+
+        std::atomic<bool> _shutdown;
+
+        // counters, only touched by the worker thread
+        unsigned long _evaluations;
+        double _total_latency;
+
+        std::thread _thread;
+    };
+
+    std::size_t _route(const std::string& session);
+
+    // the number of sessions whose workers are remembered; the next
+    // request of a session forgotten for being the least recently used
+    // is routed as if it were the first
+    static const std::size_t max_sessions = 4096;
+
+    std::vector<std::unique_ptr<Worker> > _workers;
+    // sessions with their workers, the most recently used first, and
+    // where each is in that list
+    std::list<std::pair<std::string, std::size_t> > _recent_sessions;
+    std::map<std::string, std::list<std::pair<std::string, std::size_t> >::iterator> _sessions;
+
+    std::mutex _mtx;
 };
 
 
 #endif
-
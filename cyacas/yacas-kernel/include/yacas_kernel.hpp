@@ -37,7 +37,7 @@
 
 class YacasKernel: NonCopyable {
 public:
-    YacasKernel(const std::string& scripts_path, const Json::Value&);
+    YacasKernel(const std::string& scripts_path, const Json::Value&, std::size_t nr_workers = 1, const EvaluationBudget& budget = EvaluationBudget());
 
     void run();
     
@@ -25,11 +25,34 @@
 #include "yacas_kernel.hpp"
 #include <jsoncpp/json/json.h>
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 int main(int argc, char** argv)
 {
-    if (argc < 2 || argc > 3) {
+    // the limits on each evaluation come first, followed by
+    // connection_file [scripts_path [workers]]
+    EvaluationBudget budget;
+
+    int argi = 1;
+    for (; argi + 1 < argc && argv[argi][0] == '-'; argi += 2) {
+        if (!std::strcmp(argv[argi], "--max-steps"))
+            budget.steps = std::strtoull(argv[argi + 1], nullptr, 10);
+        else if (!std::strcmp(argv[argi], "--time-limit"))
+            budget.seconds = std::strtod(argv[argi + 1], nullptr);
+        else if (!std::strcmp(argv[argi], "--memory-limit"))
+            budget.bytes = std::strtoull(argv[argi + 1], nullptr, 10) << 20;
+        else {
+            std::cerr << "yacas_kernel: unknown option " << argv[argi] << "\n";
+            return 1;
+        }
+    }
+
+    argc -= argi - 1;
+    argv += argi - 1;
+
+    if (argc < 2 || argc > 4) {
         std::cerr << "yacas_kernel: wrong number of arguments\n";
         return 1;
     }
@@ -43,13 +66,24 @@ int main(int argc, char** argv)
     
     std::string scripts_path = "/usr/share/yacas/scripts/";
     
-    if (argc == 3)
+    if (argc >= 3)
         scripts_path = argv[2];
     
     if (scripts_path.back() != '/')
         scripts_path.push_back('/');
     
-    YacasKernel kernel(scripts_path, config);
+    std::size_t nr_workers = 1;
+
+    if (argc == 4) {
+        const long n = std::strtol(argv[3], nullptr, 10);
+        if (n < 1) {
+            std::cerr << "yacas_kernel: the number of workers must be positive\n";
+            return 1;
+        }
+        nr_workers = n;
+    }
+
+    YacasKernel kernel(scripts_path, config, nr_workers, budget);
     
     kernel.run();
 }
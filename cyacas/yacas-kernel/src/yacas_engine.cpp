@@ -26,55 +26,143 @@
 
 #include "yacas_engine.hpp"
 
-YacasEngine::YacasEngine(const std::string& scripts_path, const zmqpp::context& ctx, const std::string& endpoint):
-    _yacas(_side_effects),
-    _socket(ctx, zmqpp::socket_type::pair),
-    _shutdown(false)
+YacasEngine::YacasEngine(const std::string& scripts_path, const zmqpp::context& ctx, const std::string& endpoint, std::size_t nr_workers, const EvaluationBudget& budget)
 {
-    _yacas.Evaluate(std::string("DefaultDirectory(\"") + scripts_path + std::string("\");"));
-    _yacas.Evaluate("Load(\"yacasinit.ys\");");
-    
-    _socket.connect(endpoint);
-    
-    _worker_thread = new std::thread(std::bind(&YacasEngine::_worker, this));
+    if (nr_workers == 0)
+        nr_workers = 1;
+
+    for (std::size_t i = 0; i < nr_workers; ++i)
+        _workers.emplace_back(new Worker(i, scripts_path, ctx, endpoint, budget));
 }
 
 YacasEngine::~YacasEngine()
 {
-    _shutdown = true;
-    _yacas.getDefEnv().getEnv().stop_evaluation = true;
-    _cv.notify_all();
-    _worker_thread->join();
-    
-    delete _worker_thread;
+    // the workers stop their evaluations first, and are then joined
+    // one by one as they are destroyed
+    _workers.clear();
 }
 
 
-void YacasEngine::submit(unsigned long id, const std::string& expr)
+void YacasEngine::submit(unsigned long id, const std::string& expr, const std::string& session)
+{
+    const TaskInfo ti = {id, expr, std::chrono::steady_clock::now()};
+
+    std::lock_guard<std::mutex> lock(_mtx);
+    _workers[_route(session)]->submit(ti);
+}
+
+std::size_t YacasEngine::_route(const std::string& session)
+{
+    if (!session.empty()) {
+        const auto p = _sessions.find(session);
+        if (p != _sessions.end()) {
+            _recent_sessions.splice(_recent_sessions.begin(), _recent_sessions, p->second);
+            return p->second->second;
+        }
+    }
+
+    std::size_t best = 0;
+    std::size_t best_depth = _workers[0]->queue_depth();
+    for (std::size_t i = 1; i < _workers.size() && best_depth > 0; ++i) {
+        const std::size_t depth = _workers[i]->queue_depth();
+        if (depth < best_depth) {
+            best = i;
+            best_depth = depth;
+        }
+    }
+
+    if (!session.empty()) {
+        _recent_sessions.emplace_front(session, best);
+        _sessions[session] = _recent_sessions.begin();
+
+        if (_sessions.size() > max_sessions) {
+            _sessions.erase(_recent_sessions.back().first);
+            _recent_sessions.pop_back();
+        }
+    }
+
+    return best;
+}
+
+YacasEngine::Worker::Worker(std::size_t index, const std::string& scripts_path, const zmqpp::context& ctx, const std::string& endpoint, const EvaluationBudget& budget):
+    _index(index),
+    _scripts_path(scripts_path),
+    _ctx(ctx),
+    _endpoint(endpoint),
+    _budget(budget),
+    _busy(false),
+    _yacas(nullptr),
+    _shutdown(false),
+    _evaluations(0),
+    _total_latency(0),
+    _thread(&YacasEngine::Worker::_run, this)
+{
+}
+
+YacasEngine::Worker::~Worker()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _shutdown = true;
+        if (_yacas)
+            _yacas->getDefEnv().getEnv().stop_evaluation = true;
+    }
+
+    _cv.notify_all();
+    _thread.join();
+}
+
+void YacasEngine::Worker::submit(const TaskInfo& ti)
 {
-    const TaskInfo ti = {id, expr};
-    
     std::lock_guard<std::mutex> lock(_mtx);
     _tasks.push_back(ti);
     _cv.notify_all();
 }
 
-void YacasEngine::_worker()
+std::size_t YacasEngine::Worker::queue_depth()
+{
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _tasks.size() + (_busy ? 1 : 0);
+}
+
+void YacasEngine::Worker::_run()
 {
+    std::ostringstream side_effects;
+    CYacas yacas(side_effects);
+
+    yacas.Evaluate(std::string("DefaultDirectory(\"") + _scripts_path + std::string("\");"));
+    yacas.Evaluate("If(Not(Snapshot'Load(\"yacasinit.snapshot\")),Load(\"yacasinit.ys\"));");
+
+    yacas.SetBudget(_budget);
+
+    zmqpp::socket socket(_ctx, zmqpp::socket_type::push);
+    socket.connect(_endpoint);
+
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _yacas = &yacas;
+    }
+
     for (;;) {
         TaskInfo ti;
         
         {
             std::unique_lock<std::mutex> lock(_mtx);
-    
+
+            _busy = false;
+
             while (_tasks.empty() && !_shutdown)
                 _cv.wait(lock);
             
-            if (_shutdown)
+            if (_shutdown) {
+                _yacas = nullptr;
                 return;
+            }
             
             ti = _tasks.front();
             _tasks.pop_front();
+
+            _busy = true;
         }
 
         Json::Value calculate_content;
@@ -82,26 +170,44 @@ void YacasEngine::_worker()
         calculate_content["expr"] = ti.expr;
         zmqpp::message status_msg;
         status_msg << "calculate" << Json::writeString(Json::StreamWriterBuilder(), calculate_content);
-        _socket.send(status_msg);
+        socket.send(status_msg);
         
-        _side_effects.clear();
-        _side_effects.str("");
+        side_effects.clear();
+        side_effects.str("");
 
-        _yacas.Evaluate((ti.expr + ";"));
+        const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+        yacas.Evaluate((ti.expr + ";"));
+
+        const std::chrono::steady_clock::time_point finished = std::chrono::steady_clock::now();
+
+        const double latency = std::chrono::duration<double>(finished - ti.submitted).count();
+        _evaluations += 1;
+        _total_latency += latency;
 
         Json::Value result_content;
         result_content["id"] = Json::Value::UInt64(ti.id);
         
-        if (_yacas.IsError())
-            result_content["error"] = _yacas.Error();
+        if (yacas.IsError())
+            result_content["error"] = yacas.Error();
         else
-            result_content["result"] = _yacas.Result();
+            result_content["result"] = yacas.Result();
             
-        result_content["side_effects"] = _side_effects.str();
-        
+        result_content["side_effects"] = side_effects.str();
+
+        // the latencies, in seconds, count from the submission of the
+        // request, and so include the time it was queued
+        Json::Value worker_content;
+        worker_content["worker"] = Json::Value::UInt64(_index);
+        worker_content["queue_depth"] = Json::Value::UInt64(queue_depth() - 1);
+        worker_content["evaluations"] = Json::Value::UInt64(_evaluations);
+        worker_content["evaluation_time"] = std::chrono::duration<double>(finished - started).count();
+        worker_content["latency"] = latency;
+        worker_content["mean_latency"] = _total_latency / _evaluations;
+        result_content["worker"] = worker_content;
         
         zmqpp::message result_msg;
         result_msg << "result" << Json::writeString(Json::StreamWriterBuilder(), result_content);
-        _socket.send(result_msg);
+        socket.send(result_msg);
     }
 }
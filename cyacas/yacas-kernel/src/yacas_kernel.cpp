@@ -42,16 +42,16 @@ namespace {
     }
 }
 
-YacasKernel::YacasKernel(const std::string& scripts_path, const Json::Value& config):
+YacasKernel::YacasKernel(const std::string& scripts_path, const Json::Value& config, std::size_t nr_workers, const EvaluationBudget& budget):
     _session(config["key"].asString()),
     _hb_socket(_ctx, zmqpp::socket_type::reply),
     _iopub_socket(_ctx, zmqpp::socket_type::publish),
     _control_socket(_ctx, zmqpp::socket_type::router),
     _stdin_socket(_ctx, zmqpp::socket_type::router),
     _shell_socket(_ctx, zmqpp::socket_type::router),
-    _engine_socket(_ctx, zmqpp::socket_type::pair),
+    _engine_socket(_ctx, zmqpp::socket_type::pull),
     _execution_count(1),
-    _engine(scripts_path, _ctx, "inproc://engine"),
+    _engine(scripts_path, _ctx, "inproc://engine", nr_workers, budget),
     _tex_output(true),
     _yacas(_side_effects),
     _shutdown(false)
@@ -67,7 +67,7 @@ YacasKernel::YacasKernel(const std::string& scripts_path, const Json::Value& con
     _engine_socket.bind("inproc://engine");
     
     _yacas.Evaluate(std::string("DefaultDirectory(\"") + scripts_path + std::string("\");"));
-    _yacas.Evaluate("Load(\"yacasinit.ys\");");
+    _yacas.Evaluate("If(Not(Snapshot'Load(\"yacasinit.snapshot\")),Load(\"yacasinit.ys\"));");
 }
 
 void YacasKernel::run()
@@ -235,7 +235,7 @@ void YacasKernel::_handle_shell(const std::shared_ptr<Request>& request)
     } else if (msg_type == "execute_request") {
 
         _execute_requests.insert(std::make_pair(_execution_count, std::move(request)));
-        _engine.submit(_execution_count, request->content()["code"].asString());
+        _engine.submit(_execution_count, request->content()["code"].asString(), request->header()["session"].asString());
         
         _execution_count += 1;
     } else if (msg_type == "complete_request") {
@@ -323,6 +323,9 @@ void YacasKernel::_handle_engine(const zmqpp::message& msg)
 
         request->reply(_iopub_socket, "execute_input", execute_input_content);
     } else if (msg_type == "result") {
+
+        if (content.isMember("worker"))
+            request->reply(_iopub_socket, "yacas_worker_status", content["worker"]);
         
         if (content.isMember("side_effects")) {
             Json::Value stream_content;
@@ -0,0 +1,24 @@
+#ifndef YACAS_BATCH_H
+#define YACAS_BATCH_H
+
+#include "yacas/yacas.h"
+
+#include <iosfwd>
+#include <vector>
+
+
+/** Evaluate the expressions read from \p in, each ended by \p delimiter
+ *  or by the end of the input, across the environments \p workers, as
+ *  by CYacas::EvaluateBatch, and write a record for each to \p out, in
+ *  the order they were read. A record is a header line
+ *
+ *      STATUS SECONDS LENGTH
+ *
+ *  where STATUS is ok or error and SECONDS the time the evaluation
+ *  took, followed by LENGTH bytes holding the result or the error
+ *  message, and a newline. The input is read, and the records are
+ *  written, a block of expressions at a time.
+ */
+void RunBatch(std::istream& in, std::ostream& out, char delimiter, const std::vector<CYacas*>& workers);
+
+#endif
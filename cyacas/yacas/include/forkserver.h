@@ -0,0 +1,37 @@
+#ifndef YACAS_FORKSERVER_H
+#define YACAS_FORKSERVER_H
+
+#include "yacas/yacas.h"
+
+#include <cstddef>
+#include <string>
+
+
+/** Resource limits imposed on each child of the fork server with
+ *  setrlimit. A limit which is zero is not imposed.
+ */
+struct ForkServerLimits {
+    /// CPU time of the child, over all the requests of its connection
+    unsigned long cpu_seconds = 0;
+    /// address space of the child, including its copy of the server
+    std::size_t memory_bytes = 0;
+};
+
+/** Serve connections to the Unix domain socket at \p path. For each
+ *  connection a child is forked, which starts from a copy-on-write copy
+ *  of the initialized environment of \p yacas and evaluates the
+ *  requests of the connection in turn, so that they see each other's
+ *  definitions but nothing of other connections. The child exits when
+ *  the client closes the connection.
+ *
+ *  Requests and replies are made of frames: a length as a 4-byte
+ *  unsigned integer in network byte order, followed by that many bytes.
+ *  A request is one frame holding the expression; the reply is three
+ *  frames holding the result, the side effects and the error, the last
+ *  of which is empty if the evaluation succeeded.
+ *
+ *  Returns only if the socket can not be set up, after reporting why.
+ */
+void RunForkServer(CYacas& yacas, const std::string& path, const ForkServerLimits& limits);
+
+#endif
@@ -0,0 +1,38 @@
+#include "batch.h"
+
+#include <iostream>
+#include <string>
+
+namespace {
+    // expressions evaluated between reading the input and writing the
+    // records, enough to keep all the workers busy
+    const std::size_t BlockSize = 4096;
+}
+
+void RunBatch(std::istream& in, std::ostream& out, char delimiter, const std::vector<CYacas*>& workers)
+{
+    std::vector<std::string> expressions;
+    expressions.reserve(BlockSize);
+
+    for (;;) {
+        expressions.clear();
+
+        std::string expr;
+        while (expressions.size() < BlockSize && std::getline(in, expr, delimiter))
+            expressions.push_back(expr);
+
+        if (expressions.empty())
+            break;
+
+        for (const CYacas::BatchResult& r: CYacas::EvaluateBatch(workers, expressions)) {
+            const bool failed = !r.error.empty();
+            const std::string& text = failed ? r.error : r.result;
+
+            out << (failed ? "error " : "ok ") << r.seconds << ' ' << text.size() << '\n';
+            out.write(text.data(), text.size());
+            out << '\n';
+        }
+
+        out.flush();
+    }
+}
@@ -0,0 +1,221 @@
+#include "forkserver.h"
+
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+namespace {
+    // the environment of the child, for the CPU limit handler
+    CYacas* child_yacas = nullptr;
+
+    volatile std::sig_atomic_t cpu_limit_reached = 0;
+
+    void CpuLimitHandler(int)
+    {
+        // the soft limit interrupts the evaluation in progress; the
+        // hard one, a second later, kills the child if that fails
+        cpu_limit_reached = 1;
+        child_yacas->getDefEnv().getEnv().stop_evaluation = true;
+    }
+
+    bool ReadAll(int fd, char* p, std::size_t n)
+    {
+        while (n) {
+            const ssize_t r = read(fd, p, n);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                return false;
+            p += r;
+            n -= r;
+        }
+
+        return true;
+    }
+
+    bool WriteAll(int fd, const char* p, std::size_t n)
+    {
+        while (n) {
+            const ssize_t r = write(fd, p, n);
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r <= 0)
+                return false;
+            p += r;
+            n -= r;
+        }
+
+        return true;
+    }
+
+    // the longest expression a client may send
+    const std::uint32_t max_frame_size = 16 << 20;
+
+    // on failure, error tells the client why, unless it closed the
+    // connection
+    bool ReadFrame(int fd, std::string& s, std::string& error)
+    {
+        std::uint32_t n;
+        if (!ReadAll(fd, reinterpret_cast<char*>(&n), sizeof n))
+            return false;
+
+        n = ntohl(n);
+
+        if (n > max_frame_size) {
+            error = "Request too long\n";
+            return false;
+        }
+
+        try {
+            s.resize(n);
+        } catch (const std::bad_alloc&) {
+            error = "Memory limit exceeded\n";
+            return false;
+        }
+
+        return ReadAll(fd, &s[0], s.size());
+    }
+
+    bool WriteFrame(int fd, const std::string& s)
+    {
+        const std::uint32_t n = htonl(s.size());
+
+        return WriteAll(fd, reinterpret_cast<const char*>(&n), sizeof n) &&
+               WriteAll(fd, s.data(), s.size());
+    }
+
+    void Serve(CYacas& yacas, int fd, const ForkServerLimits& limits)
+    {
+        // a client which goes away shows up as a failed write
+        signal(SIGPIPE, SIG_IGN);
+
+        if (limits.cpu_seconds) {
+            child_yacas = &yacas;
+            signal(SIGXCPU, CpuLimitHandler);
+
+            rlimit rl;
+            rl.rlim_cur = limits.cpu_seconds;
+            rl.rlim_max = limits.cpu_seconds + 1;
+            setrlimit(RLIMIT_CPU, &rl);
+        }
+
+        if (limits.memory_bytes) {
+            rlimit rl;
+            rl.rlim_cur = rl.rlim_max = limits.memory_bytes;
+            setrlimit(RLIMIT_AS, &rl);
+        }
+
+        std::ostringstream side_effects;
+        yacas.getDefEnv().getEnv().SetCurrentOutput(side_effects);
+
+        std::string expr;
+        std::string read_error;
+        while (ReadFrame(fd, expr, read_error)) {
+            side_effects.str("");
+            side_effects.clear();
+
+            std::string result;
+            std::string error;
+
+            // after running out of either resource the child can not
+            // be relied upon, and closes the connection
+            bool exhausted = false;
+
+            try {
+                yacas.Evaluate(expr);
+                result = yacas.Result();
+                error = yacas.Error();
+            } catch (const std::bad_alloc&) {
+                error = "Memory limit exceeded\n";
+                exhausted = true;
+            }
+
+            if (cpu_limit_reached) {
+                error = "CPU time limit exceeded\n";
+                exhausted = true;
+            }
+
+            if (!WriteFrame(fd, result) ||
+                !WriteFrame(fd, side_effects.str()) ||
+                !WriteFrame(fd, error) ||
+                exhausted)
+                break;
+        }
+
+        if (!read_error.empty())
+            WriteFrame(fd, "") && WriteFrame(fd, "") && WriteFrame(fd, read_error);
+    }
+}
+
+void RunForkServer(CYacas& yacas, const std::string& path, const ForkServerLimits& limits)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof address.sun_path) {
+        std::cerr << "yacas: socket path too long: " << path << "\n";
+        return;
+    }
+
+    std::strcpy(address.sun_path, path.c_str());
+
+    const int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "yacas: can't create socket: " << std::strerror(errno) << "\n";
+        return;
+    }
+
+    unlink(path.c_str());
+
+    if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof address) < 0 ||
+        listen(listener, SOMAXCONN) < 0) {
+        std::cerr << "yacas: can't listen on " << path << ": " << std::strerror(errno) << "\n";
+        close(listener);
+        return;
+    }
+
+    // the server is stopped like any other program, and its children
+    // are reaped as they exit
+    signal(SIGINT, SIG_DFL);
+    signal(SIGCHLD, SIG_IGN);
+
+    for (;;) {
+        const int connection = accept(listener, nullptr, nullptr);
+
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::cerr << "yacas: can't accept connection: " << std::strerror(errno) << "\n";
+            close(listener);
+            return;
+        }
+
+        const pid_t pid = fork();
+
+        if (pid == 0) {
+            close(listener);
+            Serve(yacas, connection, limits);
+            close(connection);
+            // leave the exit handlers and buffers of the server alone
+            _exit(EXIT_SUCCESS);
+        }
+
+        if (pid < 0)
+            std::cerr << "yacas: can't fork: " << std::strerror(errno) << "\n";
+
+        close(connection);
+    }
+}
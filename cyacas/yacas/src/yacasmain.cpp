@@ -27,6 +27,7 @@
 //          showing no prompts, and with no readline functionality.
 //
 
+#include <algorithm>
 #include <ctime>
 #include <csignal>
 #include <cstring>
@@ -49,6 +50,7 @@
 #include <libgen.h>
 
 #include "unixcommandline.h"
+#include "forkserver.h"
 #define FANCY_COMMAND_LINE CUnixCommandLine
 #else
 #define _WINSOCKAPI_            // Prevent inclusion of winsock.h in windows.h
@@ -76,6 +78,8 @@
 #include "yacas/errors.h"
 #include "yacas/string_utils.h"
 
+#include "batch.h"
+
 #ifndef YACAS_VERSION
 #include "yacas/yacas_version.h"
 #endif
@@ -100,9 +104,33 @@ bool exit_after_files = false;
 std::string root_dir;
 std::string doc_dir;
 std::string init_script = "yacasinit.ys";
+// the snapshot to start from; by default the one named after the init
+// script, with .snapshot instead of .ys
+const char* snapshot = nullptr;
+const char* save_snapshot = nullptr;
+bool compile = false;
 
 const char* read_eval_print = "REP()";
 
+// limits on each evaluation, applied once the scripts are loaded
+EvaluationBudget budget;
+
+// the file to read the expressions of a batch from, - for the standard
+// input, what separates them, and the number of environments which
+// evaluate them
+const char* batch = nullptr;
+char batch_delimiter = '\n';
+unsigned long batch_workers = 1;
+// where the side effects go in batch mode, so as not to garble the
+// records written
+std::ostream discarded_output(nullptr);
+
+#ifndef _WIN32
+// the socket to serve requests on, each connection in a child of its own
+const char* fork_server = nullptr;
+ForkServerLimits fork_server_limits;
+#endif
+
 
 static bool readmode = false;
 
@@ -223,6 +251,9 @@ static void LispReadCmdLineString(LispEnvironment& aEnvironment, int aStackTop)
     LispPtr promptObject = (ARGUMENT(1));
     const std::string prompt = InternalUnstringify(*promptObject->String());
     const std::string output = ReadInputString(prompt);
+    // each line read by the read-eval-print loop is an evaluation of
+    // its own as far as the budget is concerned
+    aEnvironment.StartBudget();
     RESULT = LispAtom::New(aEnvironment, stringify(output));
 }
 
@@ -315,7 +346,7 @@ void ShowResult(const std::string& prompt)
     std::cout << std::flush;
 }
 
-void DeclarePath(const char *ptr2)
+void DeclarePath(CYacas& y, const char *ptr2)
 {
     std::ostringstream os;
 
@@ -324,23 +355,18 @@ void DeclarePath(const char *ptr2)
     else
         os << "DefaultDirectory(\"" << ptr2 << "\");";
 
-    yacas->Evaluate(os.str());
+    y.Evaluate(os.str());
 
-    if (yacas->IsError())
-        std::cout << "Failed to set default directory: " << yacas->Error() << "\n";
+    if (y.IsError())
+        std::cout << "Failed to set default directory: " << y.Error() << "\n";
 }
 
-void LoadYacas(std::ostream& os)
+// Set up an environment the way all those of a session are: with the
+// commands of the console, the script directories and the scripts, or
+// their snapshot, loaded.
+void InitYacas(CYacas& y)
 {
-    if (yacas)
-        return;
-
-    busy = true;
-
-    yacas = new CYacas(os);
-
-
-#define CORE_KERNEL_FUNCTION(iname,fname,nrargs,flags) yacas->getDefEnv().getEnv().SetCommand(fname,iname,nrargs,flags);
+#define CORE_KERNEL_FUNCTION(iname,fname,nrargs,flags) y.getDefEnv().getEnv().SetCommand(fname,iname,nrargs,flags);
 
 #include "core_yacasmain.h"
 
@@ -362,26 +388,95 @@ void LoadYacas(std::ostream& os)
             if (*ptr1 == ';') {
 #endif
                 const std::string path(ptr2, ptr1);
-                DeclarePath(path.c_str());
+                DeclarePath(y, path.c_str());
                 ptr1++;
                 ptr2 = ptr1;
             }
         }
-        DeclarePath(ptr2);
+        DeclarePath(y, ptr2);
+
+        y.getDefEnv().getEnv().iCompileScripts = compile;
+
+        std::string snapshot_file;
+        if (snapshot)
+            snapshot_file = snapshot;
+        else if (init_script.size() > 3 && !init_script.compare(init_script.size() - 3, 3, ".ys"))
+            snapshot_file = init_script.substr(0, init_script.size() - 3) + ".snapshot";
+
+        // a snapshot which is missing or out of date is ignored
+        std::ostringstream os;
+        if (!snapshot_file.empty() && !save_snapshot && !compile)
+            os << "If(Not(Snapshot'Load(\"" << snapshot_file << "\")),Load(\"" << init_script << "\"));";
+        else
+            os << "Load(\"" << init_script << "\");";
+        y.Evaluate(os.str());
+    }
+}
+
+// The command to load a file given on the command line
+std::string LoadCommand(const char* file)
+{
+    std::ostringstream os;
+    if (patchload)
+        os << "PatchLoad(\"" << file << "\");";
+    else
+        os << "Load(\"" << file << "\");";
+    return os.str();
+}
+
+void LoadYacas(std::ostream& os)
+{
+    if (yacas)
+        return;
 
+    busy = true;
+
+    yacas = new CYacas(os);
+
+    InitYacas(*yacas);
+
+    if (yacas->IsError())
+    {
+        ShowResult("");
+        read_eval_print = nullptr;
+    }
+    else if (save_snapshot)
+    {
         std::ostringstream os;
-        os << "Load(\"" << init_script << "\");";
+        os << "Snapshot'Save(\"" << save_snapshot << "\");";
         yacas->Evaluate(os.str());
-        if (yacas->IsError())
-        {
-            ShowResult("");
-            read_eval_print = nullptr;
+        if (yacas->IsError()) {
+            std::cout << yacas->Error() << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        std::exit(EXIT_SUCCESS);
+    }
+    else if (compile)
+    {
+        // the scripts which are otherwise loaded on demand, named
+        // by string literals
+        std::vector<std::string> files;
+        for (const LispDefFiles::const_iterator::value_type& f: yacas->getDefEnv().getEnv().DefFiles())
+            if (!f.second.IsLoaded())
+                files.push_back(f.first);
+
+        for (const std::string& file: files) {
+            std::ostringstream os;
+            os << "Use(" << file << ");";
+            yacas->Evaluate(os.str());
+            if (yacas->IsError()) {
+                std::cout << "Error in file " << file << "\n"
+                          << yacas->Error() << "\n";
+                std::exit(EXIT_FAILURE);
+            }
         }
     }
 
     if (yacas->IsError())
         ShowResult("");
 
+    yacas->SetBudget(budget);
+
     if (use_texmacs_out)
         std::cout << TEXMACS_DATA_BEGIN << "verbatim:";
 
@@ -509,6 +604,17 @@ int parse_options(int argc, char** argv)
                 fileind++;
                 if (fileind<argc)
                     init_script = argv[fileind];
+            } else if (!std::strcmp(argv[fileind],"--snapshot")) {
+                fileind++;
+                if (fileind<argc)
+                    snapshot = argv[fileind];
+            } else if (!std::strcmp(argv[fileind],"--save-snapshot")) {
+                fileind++;
+                if (fileind<argc)
+                    save_snapshot = argv[fileind];
+            } else if (!std::strcmp(argv[fileind],"--compile")) {
+                compile = true;
+                exit_after_files = true;
             } else if (!std::strcmp(argv[fileind],"--read-eval-print")) {
                 fileind++;
 
@@ -522,6 +628,44 @@ int parse_options(int argc, char** argv)
                 fileind++;
                 if (fileind < argc)
                     root_dir = argv[fileind];
+            } else if (!std::strcmp(argv[fileind],"--max-steps")) {
+                fileind++;
+                if (fileind < argc)
+                    budget.steps = std::strtoull(argv[fileind], nullptr, 10);
+            } else if (!std::strcmp(argv[fileind],"--time-limit")) {
+                fileind++;
+                if (fileind < argc)
+                    budget.seconds = std::strtod(argv[fileind], nullptr);
+            } else if (!std::strcmp(argv[fileind],"--memory-limit")) {
+                fileind++;
+                if (fileind < argc)
+                    budget.bytes = std::strtoull(argv[fileind], nullptr, 10) << 20;
+#ifndef _WIN32
+            } else if (!std::strcmp(argv[fileind],"--fork-server")) {
+                fileind++;
+                if (fileind < argc)
+                    fork_server = argv[fileind];
+            } else if (!std::strcmp(argv[fileind],"--child-cpu-limit")) {
+                fileind++;
+                if (fileind < argc)
+                    fork_server_limits.cpu_seconds = std::strtoul(argv[fileind], nullptr, 10);
+            } else if (!std::strcmp(argv[fileind],"--child-memory-limit")) {
+                fileind++;
+                if (fileind < argc)
+                    fork_server_limits.memory_bytes = std::strtoull(argv[fileind], nullptr, 10) << 20;
+#endif
+            } else if (!std::strcmp(argv[fileind],"--batch")) {
+                fileind++;
+                if (fileind < argc) {
+                    batch = argv[fileind];
+                    show_prompt = false;
+                }
+            } else if (!std::strcmp(argv[fileind],"--null")) {
+                batch_delimiter = '\0';
+            } else if (!std::strcmp(argv[fileind],"--workers")) {
+                fileind++;
+                if (fileind < argc)
+                    batch_workers = std::max(std::strtoul(argv[fileind], nullptr, 10), 1ul);
             } else if (!std::strcmp(argv[fileind],"--execute")) {
                 fileind++;
                 if (fileind < argc)
@@ -563,24 +707,6 @@ int parse_options(int argc, char** argv)
                     std::cout << YACAS_VERSION << "\n";
                     std::exit(EXIT_SUCCESS);
                 }
-
-#ifndef NO_GLOBALS
-                if (std::strchr(argv[fileind],'m')) {
-                    extern void
-                        Malloc_SetHooks( void *(*malloc_func)(size_t),
-                                         void *(*calloc_func)(size_t, size_t),
-                                         void *(*realloc_func)(void *, size_t),
-                                         void (*free_func)(void *) );
-
-                    Malloc_SetHooks( malloc,
-                                     calloc,
-                                     realloc,
-                                     free );
-
-
-
-                }
-#endif
             }
         }
     }
@@ -686,19 +812,15 @@ int main(int argc, char** argv)
         outprompt = "Out> ";
     }
 
-    LoadYacas(std::cout);
+    LoadYacas(batch ? discarded_output : std::cout);
 
     if (use_texmacs_out)
         yacas->getDefEnv().getEnv().SetPrettyPrinter(yacas->getDefEnv().getEnv().HashTable().LookUp("\"TexForm\""));
 
-    for ( ; fileind<argc; fileind++) {
-        std::ostringstream os;
-        if (patchload)
-            os << "PatchLoad(\"" << argv[fileind] << "\");";
-        else
-            os << "Load(\"" << argv[fileind] << "\");";
+    const int first_file = fileind;
 
-        yacas->Evaluate(os.str());
+    for ( ; fileind<argc; fileind++) {
+        yacas->Evaluate(LoadCommand(argv[fileind]));
 
         if (yacas->IsError())
             std::cout << "Error in file " << argv[fileind] << "\n"
@@ -707,6 +829,46 @@ int main(int argc, char** argv)
         exit_after_files = true;
     }
 
+    // every environment of the batch starts out with the scripts and the
+    // files given loaded
+    if (batch) {
+        std::vector<CYacas*> workers(1, yacas);
+
+        for (unsigned long i = 1; i < batch_workers; ++i) {
+            CYacas* worker = new CYacas(discarded_output);
+            InitYacas(*worker);
+            for (int f = first_file; f < argc; ++f)
+                worker->Evaluate(LoadCommand(argv[f]));
+            worker->SetBudget(budget);
+            workers.push_back(worker);
+        }
+
+        if (!std::strcmp(batch, "-")) {
+            RunBatch(std::cin, std::cout, batch_delimiter, workers);
+        } else {
+            std::ifstream in(batch, std::ios::binary);
+            if (!in) {
+                std::cerr << "yacas: can't open " << batch << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            RunBatch(in, std::cout, batch_delimiter, workers);
+        }
+
+        for (std::size_t i = 1; i < workers.size(); ++i)
+            delete workers[i];
+
+        std::exit(EXIT_SUCCESS);
+    }
+
+#ifndef _WIN32
+    // the files given are loaded into the environment the children
+    // start from
+    if (fork_server) {
+        RunForkServer(*yacas, fork_server, fork_server_limits);
+        std::exit(EXIT_FAILURE);
+    }
+#endif
+
     if (exit_after_files)
         std::exit(EXIT_SUCCESS);
 
@@ -0,0 +1,120 @@
+#! /usr/bin/env python3
+#
+# test-fork-server.py -- Check the replies of the fork server, and that
+# connections don't see each other's definitions
+
+import os
+import shlex
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def send_frame(s, data):
+    s.sendall(struct.pack('!I', len(data)) + data)
+
+
+def recv_exactly(s, n):
+    data = b''
+    while len(data) < n:
+        chunk = s.recv(n - len(data))
+        if not chunk:
+            raise EOFError('connection closed')
+        data += chunk
+    return data
+
+
+def recv_frame(s):
+    n, = struct.unpack('!I', recv_exactly(s, 4))
+    return recv_exactly(s, n).decode()
+
+
+def evaluate(s, expr):
+    send_frame(s, expr.encode())
+    return recv_frame(s), recv_frame(s), recv_frame(s)
+
+
+def connect(path):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.settimeout(60)
+    s.connect(path)
+    return s
+
+
+failures = []
+
+
+def check(what, got, expected):
+    if got != expected:
+        failures.append('%s: got %r instead of %r' % (what, got, expected))
+
+
+def main():
+    if len(sys.argv) != 2:
+        print('Usage: %s <cmd>' % sys.argv[0])
+        print('  cmd       Command plus options, needed to run Yacas')
+        return 255
+
+    path = os.path.join(tempfile.mkdtemp(), 'yacas.socket')
+    server = subprocess.Popen(shlex.split(sys.argv[1]) + ['--fork-server', path])
+
+    try:
+        for _ in range(600):
+            if os.path.exists(path) or server.poll() is not None:
+                break
+            time.sleep(0.1)
+
+        a = connect(path)
+        b = connect(path)
+
+        check('result', evaluate(a, 'x := 2^70'), ('1180591620717411303424;', '', ''))
+        check('side effects', evaluate(a, 'Echo(x+1)'), ('True;', '1180591620717411303425 \n', ''))
+
+        result, side_effects, error = evaluate(a, 'Factor(x')
+        check('syntax error', (result, side_effects), ('', ''))
+        if not error:
+            failures.append('syntax error: no error message')
+
+        # each connection has a child of its own
+        check('other connection', evaluate(b, 'x'), ('x;', '', ''))
+        check('same connection', evaluate(a, 'x'), ('1180591620717411303424;', '', ''))
+
+        a.close()
+        b.close()
+
+        # the definitions of a closed connection don't last either
+        c = connect(path)
+        check('new connection', evaluate(c, 'x'), ('x;', '', ''))
+
+        # a request which is too long is refused with an error, after
+        # which the child closes the connection
+        c.sendall(struct.pack('!I', 0xffffffff))
+        result, side_effects, error = recv_frame(c), recv_frame(c), recv_frame(c)
+        check('long request', (result, side_effects), ('', ''))
+        if not error:
+            failures.append('long request: no error message')
+        check('closed after long request', c.recv(1), b'')
+        c.close()
+    except (OSError, EOFError) as e:
+        failures.append('connection failed: %s' % e)
+    finally:
+        server.terminate()
+        server.wait()
+        if os.path.exists(path):
+            os.unlink(path)
+        os.rmdir(os.path.dirname(path))
+
+    for failure in failures:
+        print(failure)
+
+    if not failures:
+        print('passed')
+
+    return len(failures)
+
+
+if __name__ == '__main__':
+    sys.exit(main())